@@ -1,8 +1,15 @@
 #pragma once
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
 // #include <limits>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "clsocket/ActiveSocket.h"
@@ -12,11 +19,25 @@ namespace rewind_viewer {
 
 constexpr uint16_t MESSAGE_SCHEMA_VERSION = 5;
 
+// Primitives are not sent one by one: each message is appended, size-prefixed as on the wire,
+// to the current frame, and end_frame() hands the whole frame to a background thread that
+// writes it to the socket in one go. A slow viewer never blocks the caller; if it falls more
+// than MAX_QUEUED_FRAMES behind, whole frames are dropped.
 class RewindClient {
  public:
+  // Receives every finished frame (its size-prefixed messages, as the viewer reads them from
+  // the socket) on the sender thread.
+  using FrameSink = std::function<void(const uint8_t *data, size_t size)>;
+
   RewindClient(const RewindClient &) = delete;
   RewindClient &operator=(const RewindClient &) = delete;
 
+  // Frames go to `sink` instead of a viewer, e.g. to record them for later playback.
+  explicit RewindClient(FrameSink sink) : sink_(std::move(sink)) {
+    is_little_endian_ = detect_little_endian();
+    sender_ = std::thread([this] { send_frames(); });
+  }
+
   RewindClient(const std::string &host, uint16_t port) {
     socket_.Initialize();
     socket_.DisableNagleAlgoritm();
@@ -24,14 +45,13 @@ class RewindClient {
       fprintf(stderr, "RewindClient:: Cannot open viewer socket. Launch viewer before behavior\n");
     }
 
-    // Could be std::endian::native == std::endian::little in c++20
-    const int32_t value{0x01};
-    const void *address{static_cast<const void *>(&value)};
-    const unsigned char *least_significant_address{static_cast<const unsigned char *>(address)};
-    is_little_endian_ = *least_significant_address == 0x01;
+    is_little_endian_ = detect_little_endian();
 
     // Send protocol version 1 start_time on connection.
     send_protocol_version();
+    if (socket_.IsSocketValid()) {
+      sender_ = std::thread([this] { send_frames(); });
+    }
   }
 
   ~RewindClient() {
@@ -48,6 +68,7 @@ class RewindClient {
     auto msg = fbs::CreateRewindMessage(builder_, fbs::Command_EndFrame, command.Union());
     builder_.Finish(msg);
     send(builder_.GetBufferPointer(), builder_.GetSize());
+    queue_frame();
   }
 
   void switch_to_layer(size_t layer, bool permanent = false) {
@@ -318,7 +339,20 @@ template <typename Vec2T>
     send(builder_.GetBufferPointer(), builder_.GetSize());
   }
 
+  // Sends what is queued, including an unfinished frame, then closes the socket.
   void close() {
+    if (sender_.joinable()) {
+      queue_frame();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+      }
+      wake_.notify_one();
+      sender_.join();
+      if (dropped_frames_ > 0) {
+        fprintf(stderr, "RewindClient:: %zu frames dropped, too slow\n", dropped_frames_);
+      }
+    }
     if (socket_.IsSocketValid()) {
       if (!socket_.Shutdown(CSimpleSocket::CShutdownMode::Both)) {
         // ???
@@ -333,6 +367,25 @@ template <typename Vec2T>
   CActiveSocket socket_;
   uint32_t opacity_{0xFF000000};
   constexpr static uint64_t MAX_MESSAGE_SIZE = 1024 * 1024;  // 1MB
+  constexpr static size_t MAX_QUEUED_FRAMES = 16;
+
+  FrameSink sink_;  // replaces the socket when set
+  std::vector<uint8_t> frame_;  // messages since the last end_frame, size-prefixed
+  std::thread sender_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::vector<uint8_t>> queued_;
+  std::vector<std::vector<uint8_t>> free_buffers_;  // sent frames, reused to avoid allocations
+  bool stopping_ = false;
+  size_t dropped_frames_ = 0;
+
+  static bool detect_little_endian() {
+    // Could be std::endian::native == std::endian::little in c++20
+    const int32_t value{0x01};
+    const void *address{static_cast<const void *>(&value)};
+    const unsigned char *least_significant_address{static_cast<const unsigned char *>(address)};
+    return *least_significant_address == 0x01;
+  }
 
   void send_protocol_version() {
     static uint8_t buffer[sizeof(int16_t)];
@@ -343,18 +396,78 @@ template <typename Vec2T>
     socket_.Send(buffer, sizeof(int16_t));
   }
 
+  // Appends the message to the current frame.
   void send(const uint8_t *buf, uint64_t buf_size) {
     //    if (buf_size > std::numeric_limits<uint32_t>::max()) {
     if (buf_size > MAX_MESSAGE_SIZE) {
       throw std::runtime_error("Rewind message size can't be more then 1MB");
     }
-    static uint8_t buffer[sizeof(int32_t)];
-    memcpy(buffer, &buf_size, sizeof(int32_t));
+    uint8_t buffer[sizeof(int32_t)];
+    const auto size = static_cast<uint32_t>(buf_size);
+    memcpy(buffer, &size, sizeof(int32_t));
     if (!is_little_endian_) {
       std::reverse(buffer, buffer + sizeof(uint32_t));
     }
-    socket_.Send(buffer, sizeof(int32_t));
-    socket_.Send(buf, buf_size);
+    frame_.insert(frame_.end(), buffer, buffer + sizeof(int32_t));
+    frame_.insert(frame_.end(), buf, buf + buf_size);
+  }
+
+  void queue_frame() {
+    if (frame_.empty()) {
+      return;
+    }
+    if (!sender_.joinable()) {  // no viewer
+      frame_.clear();
+      return;
+    }
+    std::vector<uint8_t> next;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (queued_.size() >= MAX_QUEUED_FRAMES) {
+        dropped_frames_++;
+        frame_.clear();
+        return;
+      }
+      queued_.push_back(std::move(frame_));
+      if (!free_buffers_.empty()) {
+        next = std::move(free_buffers_.back());
+        free_buffers_.pop_back();
+      }
+    }
+    wake_.notify_one();
+    frame_ = std::move(next);
+  }
+
+  // Background thread: one Send per frame (more only if the kernel takes it in parts), or one
+  // sink call.
+  void send_frames() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wake_.wait(lock, [this] { return stopping_ || !queued_.empty(); });
+      if (queued_.empty()) {
+        return;
+      }
+      auto frame = std::move(queued_.front());
+      queued_.pop_front();
+      lock.unlock();
+      if (sink_) {
+        sink_(frame.data(), frame.size());
+      } else {
+        const uint8_t *data = frame.data();
+        size_t left = frame.size();
+        while (left > 0) {
+          int32 sent = socket_.Send(data, left);
+          if (sent <= 0) {
+            break;
+          }
+          data += sent;
+          left -= static_cast<size_t>(sent);
+        }
+      }
+      frame.clear();
+      lock.lock();
+      free_buffers_.push_back(std::move(frame));
+    }
   }
 
   template <typename... Args>
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace mortido::bench {
+
+template <typename T>
+inline void do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result {
+  std::string name;
+  size_t iterations = 0;
+  double ns_per_op = 0.0;
+  size_t bytes_per_op = 0;
+  size_t items_per_op = 0;  // turns, entities, ...: reported as items/s when set
+};
+
+// Runs `fn` until `min_time` has passed (at least `min_iterations` times) and reports the mean.
+template <typename F>
+Result run(std::string name, F&& fn, size_t bytes_per_op = 0,
+           std::chrono::milliseconds min_time = std::chrono::milliseconds(500),
+           size_t min_iterations = 10) {
+  fn();  // warm-up
+  size_t iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto elapsed = std::chrono::steady_clock::duration::zero();
+  while (iterations < min_iterations || elapsed < min_time) {
+    fn();
+    iterations++;
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  return Result{std::move(name), iterations, ns / static_cast<double>(iterations), bytes_per_op};
+}
+
+// Same as run(), but calls `setup` before every `fn` call and only times `fn`.
+template <typename S, typename F>
+Result run_with_setup(std::string name, S&& setup, F&& fn, size_t bytes_per_op = 0,
+                      std::chrono::milliseconds min_time = std::chrono::milliseconds(500),
+                      size_t min_iterations = 10) {
+  setup();
+  fn();  // warm-up
+  size_t iterations = 0;
+  auto elapsed = std::chrono::steady_clock::duration::zero();
+  while (iterations < min_iterations || elapsed < min_time) {
+    setup();
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    elapsed += std::chrono::steady_clock::now() - start;
+    iterations++;
+  }
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  return Result{std::move(name), iterations, ns / static_cast<double>(iterations), bytes_per_op};
+}
+
+inline void print_header() {
+  std::printf("%-44s %12s %14s %10s %12s\n", "benchmark", "iterations", "ns/op", "MB/s",
+              "items/s");
+}
+
+inline void print(const Result& result) {
+  double mb_per_s = result.bytes_per_op > 0
+                        ? static_cast<double>(result.bytes_per_op) / result.ns_per_op * 1e9 / 1e6
+                        : 0.0;
+  double items_per_s = static_cast<double>(result.items_per_op) / result.ns_per_op * 1e9;
+  std::printf("%-44s %12zu %14.1f %10.1f %12.0f\n", result.name.c_str(), result.iterations,
+              result.ns_per_op, mb_per_s, items_per_s);
+}
+
+// Allocation budget of a benchmark that counts allocations (alloc_hooks.h): reports and returns
+// false when it allocated more than `budget` times per op, so the run can fail.
+inline bool within_budget(const std::string& name, double allocations_per_op, double budget) {
+  if (allocations_per_op <= budget) {
+    return true;
+  }
+  std::fprintf(stderr, "%s: %.1f allocations/op, over the budget of %.1f\n", name.c_str(),
+               allocations_per_op, budget);
+  return false;
+}
+
+}  // namespace mortido::bench
@@ -0,0 +1,115 @@
+// Encoding cost of api::Command: the old DOM + StringBuffer + std::string path against
+// CommandWriter.
+//
+// usage: mortido-bench-command [seed]
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+
+#include "api/command_writer.h"
+#include "bench.h"
+
+namespace {
+
+using mortido::api::AttackCommand;
+using mortido::api::Command;
+using mortido::models::vec2i;
+
+Command make_command(size_t attacks, size_t builds, std::mt19937& rng) {
+  std::uniform_int_distribution<int> coord(0, 299);
+  Command command;
+  for (size_t i = 0; i < attacks; i++) {
+    command.attack.push_back(AttackCommand{
+        .block_id = "f4b7d2c8-" + std::to_string(rng()) + "-" + std::to_string(i),
+        .target = vec2i{coord(rng), coord(rng)},
+        .source = vec2i{coord(rng), coord(rng)},
+    });
+  }
+  for (size_t i = 0; i < builds; i++) {
+    command.build.emplace_back(coord(rng), coord(rng));
+  }
+  command.move_base = vec2i{coord(rng), coord(rng)};
+  return command;
+}
+
+// The encoding HttpApi::send_command used before CommandWriter, including the copy into the
+// request body.
+std::string encode_dom(const Command& command) {
+  rapidjson::Document doc;
+  doc.SetObject();
+  auto& allocator = doc.GetAllocator();
+
+  rapidjson::Value attack_array(rapidjson::kArrayType);
+  for (const auto& attack_cmd : command.attack) {
+    rapidjson::Value attack_obj(rapidjson::kObjectType);
+    attack_obj.AddMember(
+        "blockId", rapidjson::Value().SetString(attack_cmd.block_id.c_str(), allocator), allocator);
+
+    rapidjson::Value target_obj(rapidjson::kObjectType);
+    target_obj.AddMember("x", attack_cmd.target.x, allocator);
+    target_obj.AddMember("y", attack_cmd.target.y, allocator);
+
+    attack_obj.AddMember("target", target_obj, allocator);
+    attack_array.PushBack(attack_obj, allocator);
+  }
+  doc.AddMember("attack", attack_array, allocator);
+
+  rapidjson::Value build_array(rapidjson::kArrayType);
+  for (const auto& build_pos : command.build) {
+    rapidjson::Value build_obj(rapidjson::kObjectType);
+    build_obj.AddMember("x", build_pos.x, allocator);
+    build_obj.AddMember("y", build_pos.y, allocator);
+    build_array.PushBack(build_obj, allocator);
+  }
+  doc.AddMember("build", build_array, allocator);
+
+  if (command.move_base.has_value()) {
+    rapidjson::Value move_base_obj(rapidjson::kObjectType);
+    move_base_obj.AddMember("x", command.move_base->x, allocator);
+    move_base_obj.AddMember("y", command.move_base->y, allocator);
+    doc.AddMember("moveBase", move_base_obj, allocator);
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  doc.Accept(writer);
+  return buffer.GetString();
+}
+
+// "<name> <size>x<size>"
+std::string label(const char* name, size_t size) {
+  std::string text = name;
+  text.append(" ").append(std::to_string(size)).append("x").append(std::to_string(size));
+  return text;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::mt19937 rng(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 42);
+  mortido::api::CommandWriter command_writer;
+
+  mortido::bench::print_header();
+  for (size_t size : {10, 100, 1000, 5000}) {
+    auto command = make_command(size, size, rng);
+    auto expected = encode_dom(command);
+    if (command_writer.encode(command) != expected) {
+      std::fprintf(stderr, "CommandWriter output differs from the DOM encoding\n");
+      return EXIT_FAILURE;
+    }
+
+    mortido::bench::print(mortido::bench::run(
+        label("dom", size), [&] { mortido::bench::do_not_optimize(encode_dom(command)); },
+        expected.size()));
+    mortido::bench::print(mortido::bench::run(
+        label("writer", size),
+        [&] { mortido::bench::do_not_optimize(command_writer.encode(command).data()); },
+        expected.size()));
+  }
+  return EXIT_SUCCESS;
+}
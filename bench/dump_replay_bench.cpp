@@ -0,0 +1,167 @@
+// Replay throughput of a dump_v2 file in turns per second: the old DumpApi loop, which parsed
+// the last `/units` body again on every iteration, against the single pass scanner.
+//
+// usage: mortido-bench-replay <file.dump>
+
+#include <rapidjson/document.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "api/dump_v2.h"
+#include "bench.h"
+
+namespace {
+
+using mortido::api::Command;
+using mortido::api::DumpApi;
+
+// The read loop DumpApi used before DumpScanner, kept to compare against.
+class LegacyReplay {
+ public:
+  explicit LegacyReplay(const std::filesystem::path& dump_file) : file_stream_(dump_file) {}
+
+  bool next_units(rapidjson::Document& units_doc) {
+    read_turn();
+    if (game_ended_) {
+      return false;
+    }
+    units_doc.Parse(last_units_json_string_.c_str());
+    turn_++;
+    return true;
+  }
+
+ private:
+  int turn_ = 0;
+  std::string last_world_json_string_;
+  std::string last_units_json_string_;
+  std::ifstream file_stream_;
+  bool game_ended_ = false;
+
+  void read_turn() {
+    std::string line;
+    std::string handle;
+    std::string temp;
+
+    while (true) {
+      rapidjson::Document temp_units_doc;
+      temp_units_doc.Parse(last_units_json_string_.c_str());
+      if (!temp_units_doc.HasParseError() && temp_units_doc.HasMember("turn") &&
+          temp_units_doc["turn"].GetInt() >= turn_) {
+        turn_ = temp_units_doc["turn"].GetInt();
+        break;
+      }
+
+      if (!read_dump_segment("REQUEST", line)) {
+        game_ended_ = true;
+        break;
+      }
+
+      std::istringstream stream(line);
+      stream >> temp >> temp >> handle;
+      std::string* segment_json_ptr = nullptr;
+      if (handle == "/play/zombidef/world") {
+        segment_json_ptr = &last_world_json_string_;
+      } else if (handle == "/play/zombidef/units") {
+        segment_json_ptr = &last_units_json_string_;
+      }
+
+      if (!read_dump_segment("RESPONSE", line) ||
+          !read_dump_segment("~~~~~~~~~~~~~", line, segment_json_ptr)) {
+        game_ended_ = true;
+        break;
+      }
+    }
+  }
+
+  bool read_dump_segment(const std::string& line_flag, std::string& line,
+                         std::string* segment = nullptr) {
+    line.clear();
+    std::stringstream segment_data;
+    while (std::getline(file_stream_, line) && line.compare(0, line_flag.size(), line_flag) != 0) {
+      segment_data << line << std::endl;
+    }
+    if (line.compare(0, line_flag.size(), line_flag) != 0) {
+      return false;
+    }
+    if (segment != nullptr) {
+      *segment = segment_data.str();
+    }
+    return true;
+  }
+};
+
+size_t replay_legacy(const std::filesystem::path& dump_file) {
+  LegacyReplay replay(dump_file);
+  rapidjson::Document units_doc;
+  size_t turns = 0;
+  while (replay.next_units(units_doc)) {
+    mortido::bench::do_not_optimize(units_doc.MemberCount());
+    turns++;
+  }
+  return turns;
+}
+
+size_t replay_dom(const std::filesystem::path& dump_file) {
+  DumpApi api(dump_file);
+  size_t turns = 0;
+  while (true) {
+    auto units_doc = api.get_units();
+    if (!api.active()) {
+      break;
+    }
+    mortido::bench::do_not_optimize(units_doc.MemberCount());
+    api.send_command(Command{});
+    turns++;
+  }
+  return turns;
+}
+
+size_t replay_json(const std::filesystem::path& dump_file) {
+  DumpApi api(dump_file);
+  size_t turns = 0;
+  while (true) {
+    auto units_json = api.get_units_json();
+    if (!api.active()) {
+      break;
+    }
+    mortido::bench::do_not_optimize(units_json.data());
+    api.send_command(Command{});
+    turns++;
+  }
+  return turns;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <file.dump>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  std::filesystem::path dump_file = argv[1];
+  size_t dump_size = std::filesystem::file_size(dump_file);
+
+  size_t turns = replay_json(dump_file);
+  if (replay_dom(dump_file) != turns || replay_legacy(dump_file) != turns) {
+    std::fprintf(stderr, "Replays disagree on the number of turns\n");
+    return EXIT_FAILURE;
+  }
+  std::printf("%s: %zu turns, %zu bytes\n", dump_file.c_str(), turns, dump_size);
+
+  mortido::bench::print_header();
+  auto bench = [&](std::string name, size_t (*replay)(const std::filesystem::path&)) {
+    auto result = mortido::bench::run(
+        std::move(name), [&] { mortido::bench::do_not_optimize(replay(dump_file)); }, dump_size);
+    result.items_per_op = turns;
+    mortido::bench::print(result);
+  };
+  bench("legacy reparse", replay_legacy);
+  bench("scanner get_units", replay_dom);
+  bench("scanner get_units_json", replay_json);
+  return EXIT_SUCCESS;
+}
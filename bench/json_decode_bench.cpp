@@ -0,0 +1,219 @@
+// Decode cost of real `/units` and `/world` bodies, split into phases: rapidjson parsing,
+// field extraction into Building/Zombie and filling the Map. `/units` bodies are sampled from
+// the given dumps by size (smallest, quartiles, largest), so early and late game are covered.
+// Both decode paths are measured: the DOM one (Document + update_from_json) and the SAX one
+// the game uses (UnitsReader, whose extraction cost is its time minus a bare tokenize).
+//
+// usage: mortido-bench-json <file.dump>...
+
+#include <rapidjson/document.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api/dump_format.h"
+#include "api/dump_scanner.h"
+#include "api/mapped_file.h"
+#include "bench.h"
+#include "models/state.h"
+#include "models/units_reader.h"
+
+namespace {
+
+using mortido::models::Building;
+using mortido::models::State;
+using mortido::models::UnitsSnapshot;
+using mortido::models::Zombie;
+
+struct Sample {
+  std::string label;
+  std::string body;
+};
+
+// Tokenizes without building anything, the floor for any rapidjson based decoder.
+bool tokenize(const std::string& json) {
+  rapidjson::BaseReaderHandler<> handler;
+  rapidjson::Reader reader;
+  rapidjson::MemoryStream stream(json.data(), json.size());
+  return !reader.Parse(stream, handler).IsError();
+}
+
+// The extraction half of State::update_from_json.
+void extract_dom(const rapidjson::Document& doc, UnitsSnapshot& out) {
+  out.clear();
+  for (const char* list : {"base", "enemyBlocks"}) {
+    if (doc.HasMember(list) && doc[list].IsArray()) {
+      for (const auto& value : doc[list].GetArray()) {
+        auto& building = list[0] == 'b' ? out.base.emplace_back() : out.enemy_blocks.emplace_back();
+        building.update_from_json(value);
+      }
+    }
+  }
+  if (doc.HasMember("zombies") && doc["zombies"].IsArray()) {
+    for (const auto& value : doc["zombies"].GetArray()) {
+      out.zombies.emplace_back().update_from_json(value);
+    }
+  }
+  out.player.update_from_json(doc["player"]);
+}
+
+// The Map half of State::update_from_units, without Map::update.
+void fill(State& state, UnitsSnapshot& units) {
+  state.map.clear();
+  for (auto& b : units.base) {
+    state.map.add_building(std::move(b));
+  }
+  for (auto& b : units.enemy_blocks) {
+    state.map.add_building(std::move(b));
+  }
+  for (auto& zombie : units.zombies) {
+    state.map.add_zombie(std::move(zombie));
+  }
+}
+
+void bench_units(const Sample& sample, State& state) {
+  mortido::models::UnitsReader units_reader;
+  UnitsSnapshot snapshot;
+  if (!units_reader.read(sample.body, snapshot)) {
+    std::fprintf(stderr, "%s: body does not parse\n", sample.label.c_str());
+    return;
+  }
+  size_t entities = snapshot.base.size() + snapshot.enemy_blocks.size() + snapshot.zombies.size();
+  size_t bytes = sample.body.size();
+  std::printf("\n%s: %zu bytes, %zu blocks, %zu enemy blocks, %zu zombies\n",
+              sample.label.c_str(), bytes, snapshot.base.size(), snapshot.enemy_blocks.size(),
+              snapshot.zombies.size());
+
+  auto report = [&](mortido::bench::Result result) {
+    result.items_per_op = entities;
+    mortido::bench::print(result);
+  };
+  rapidjson::Document doc;
+  UnitsSnapshot out;
+  report(mortido::bench::run(
+      "tokenize", [&] { mortido::bench::do_not_optimize(tokenize(sample.body)); }, bytes));
+  report(mortido::bench::run(
+      "dom parse",
+      [&] {
+        doc.Parse(sample.body.data(), sample.body.size());
+        mortido::bench::do_not_optimize(doc.MemberCount());
+      },
+      bytes));
+  report(mortido::bench::run(
+      "dom extract",
+      [&] {
+        extract_dom(doc, out);
+        mortido::bench::do_not_optimize(out.zombies.size());
+      },
+      bytes));
+  report(mortido::bench::run(
+      "sax read (parse + extract)",
+      [&] { mortido::bench::do_not_optimize(units_reader.read(sample.body, out)); }, bytes));
+  report(mortido::bench::run_with_setup(
+      "map fill", [&] { out = snapshot; },
+      [&] {
+        fill(state, out);
+        mortido::bench::do_not_optimize(state.map.buildings.size());
+      },
+      bytes));
+}
+
+void bench_world(const Sample& sample, State& state) {
+  rapidjson::Document doc;
+  doc.Parse(sample.body.data(), sample.body.size());
+  if (doc.HasParseError() || !doc.HasMember("zpots") || !doc["zpots"].IsArray()) {
+    std::fprintf(stderr, "%s: not a world body\n", sample.label.c_str());
+    return;
+  }
+  size_t entities = doc["zpots"].Size();
+  size_t bytes = sample.body.size();
+  std::printf("\n%s: %zu bytes, %zu zpots\n", sample.label.c_str(), bytes, entities);
+
+  auto report = [&](mortido::bench::Result result) {
+    result.items_per_op = entities;
+    mortido::bench::print(result);
+  };
+  report(mortido::bench::run(
+      "tokenize", [&] { mortido::bench::do_not_optimize(tokenize(sample.body)); }, bytes));
+  report(mortido::bench::run(
+      "dom parse",
+      [&] {
+        doc.Parse(sample.body.data(), sample.body.size());
+        mortido::bench::do_not_optimize(doc.MemberCount());
+      },
+      bytes));
+  report(mortido::bench::run(
+      "extract + map fill",
+      [&] {
+        state.init_from_json(doc);
+        mortido::bench::do_not_optimize(state.map.walls.size());
+      },
+      bytes));
+}
+
+// "<what> (<file>)"
+std::string label(std::string_view what, const char* file) {
+  std::string text(what);
+  text.append(" (").append(file).append(")");
+  return text;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <file.dump>...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Sample> units;
+  Sample world;
+  for (int i = 1; i < argc; i++) {
+    mortido::api::MappedFile file(argv[i]);
+    mortido::api::DumpScanner scanner(file.data());
+    mortido::api::DumpSegment segment;
+    while (scanner.next(segment)) {
+      if (segment.http_code != 200) {
+        continue;
+      }
+      if (segment.handle == mortido::api::kUnitsHandle && segment.turn) {
+        units.push_back(Sample{label("units turn " + std::to_string(*segment.turn), argv[i]),
+                               std::string(segment.response)});
+      } else if (segment.handle == mortido::api::kWorldHandle &&
+                 segment.response.size() > world.body.size()) {
+        world = Sample{label("world", argv[i]), std::string(segment.response)};
+      }
+    }
+  }
+  if (units.empty()) {
+    std::fprintf(stderr, "no /units bodies found\n");
+    return EXIT_FAILURE;
+  }
+
+  std::sort(units.begin(), units.end(),
+            [](const Sample& a, const Sample& b) { return a.body.size() < b.body.size(); });
+  std::vector<size_t> picks;
+  for (double quantile : {0.0, 0.25, 0.5, 0.75, 1.0}) {
+    auto pick = static_cast<size_t>(quantile * static_cast<double>(units.size() - 1));
+    if (picks.empty() || picks.back() != pick) {
+      picks.push_back(pick);
+    }
+  }
+
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+  State state;
+  mortido::bench::print_header();
+  for (size_t pick : picks) {
+    bench_units(units[pick], state);
+  }
+  if (!world.body.empty()) {
+    bench_world(world, state);
+  }
+  return EXIT_SUCCESS;
+}
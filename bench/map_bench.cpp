@@ -0,0 +1,223 @@
+// Decision pass cost on synthetic, seeded scenarios (sim/scenario.h): Map::update and each of
+// State::attack, State::build and State::move_base timed separately, in ns/op and heap
+// allocations per op.
+// Every op starts from the same freshly loaded state; loading it is not timed. Exits non-zero
+// when a phase goes over its allocation budget (kAllocationBudgets).
+//
+// usage: mortido-bench-map [--seed <seed>] [--turn <turn>]
+//            [--size <n> --zombies <n> --own <n> --enemy <n> --spawns <n>]
+// Without a custom scenario the preset ones are run.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "alloc_hooks.h"
+#include "bench.h"
+#include "models/state.h"
+#include "sim/scenario.h"
+
+namespace {
+
+using mortido::models::State;
+using mortido::models::vec2i;
+
+struct Scenario {
+  std::string name;
+  int size = 0;
+  size_t zombies = 0;
+  size_t own = 0;
+  size_t enemy = 0;
+  size_t spawns = 0;
+};
+
+mortido::sim::Scenario make_world(const Scenario& scenario, uint32_t seed, int turn) {
+  mortido::sim::ScenarioConfig config;
+  config.seed = seed;
+  config.size = scenario.size;
+  config.spawns = scenario.spawns;
+  config.walls = scenario.spawns;
+  config.base = scenario.own;
+  config.enemy = scenario.enemy;
+  config.set_zombies(scenario.zombies);
+  config.turn = turn;
+  return mortido::sim::ScenarioGenerator(config).generate();
+}
+
+// What State::update_from_units does before Map::update, on a copy of the scenario.
+void load(State& state, const mortido::sim::Scenario& world, int turn) {
+  state.turn = turn;
+  state.me = world.units.player;
+  state.map.clear();
+  for (const auto& b : world.units.base) {
+    state.map.add_building(b);
+  }
+  for (const auto& b : world.units.enemy_blocks) {
+    state.map.add_building(b);
+  }
+  for (const auto& z : world.units.zombies) {
+    state.map.add_zombie(z);
+  }
+}
+
+struct PhaseResult {
+  size_t iterations = 0;
+  double ns_per_op = 0.0;
+  double allocations_per_op = 0.0;
+  double bytes_per_op = 0.0;
+};
+
+// Runs `prepare` (untimed) and `op` (timed) until `min_time` of op time has been collected,
+// or `max_wall_time` has passed when prepare dominates.
+template <typename Prepare, typename Op>
+PhaseResult measure(Prepare&& prepare, Op&& op,
+                    std::chrono::milliseconds min_time = std::chrono::milliseconds(300),
+                    std::chrono::milliseconds max_wall_time = std::chrono::seconds(3),
+                    size_t min_iterations = 5) {
+  prepare();
+  op();  // warm-up, fills the caches op keeps (attack directions, zombie prototypes)
+  PhaseResult result;
+  auto timed = std::chrono::steady_clock::duration::zero();
+  size_t allocations = 0;
+  size_t bytes = 0;
+  auto wall_start = std::chrono::steady_clock::now();
+  while (result.iterations < min_iterations ||
+         (timed < min_time && std::chrono::steady_clock::now() - wall_start < max_wall_time)) {
+    prepare();
+    mortido::alloc::Scope allocs;
+    auto start = std::chrono::steady_clock::now();
+    op();
+    timed += std::chrono::steady_clock::now() - start;
+    auto delta = allocs.delta();
+    allocations += delta.allocations;
+    bytes += delta.bytes;
+    result.iterations++;
+  }
+  auto n = static_cast<double>(result.iterations);
+  result.ns_per_op = std::chrono::duration<double, std::nano>(timed).count() / n;
+  result.allocations_per_op = static_cast<double>(allocations) / n;
+  result.bytes_per_op = static_cast<double>(bytes) / n;
+  return result;
+}
+
+// Allocations per op allowed in phases that must not touch the heap once warmed up; any
+// scenario going over fails the run.
+constexpr std::pair<std::string_view, double> kAllocationBudgets[] = {
+    {"move_base", 0.0},
+};
+
+// Returns false if the phase went over its allocation budget.
+bool print(const std::string& scenario, const char* phase, const PhaseResult& result) {
+  std::printf("%-24s %-12s %10zu %14.1f %12.1f %12.1f\n", scenario.c_str(), phase,
+              result.iterations, result.ns_per_op, result.allocations_per_op,
+              result.bytes_per_op / 1024.0);
+  std::fflush(stdout);
+  for (const auto& [budget_phase, budget] : kAllocationBudgets) {
+    if (budget_phase == phase) {
+      return mortido::bench::within_budget(scenario + " " + phase, result.allocations_per_op,
+                                           budget);
+    }
+  }
+  return true;
+}
+
+bool run(const Scenario& scenario, uint32_t seed, int turn) {
+  auto world = make_world(scenario, seed, turn);
+  State state;
+  for (auto pos : world.spawns) state.map.add_spawn(pos);
+  for (auto pos : world.walls) state.map.add_wall(pos);
+  state.map.ensure_size(vec2i{scenario.size - 1, scenario.size - 1});
+
+  auto loaded = [&] { load(state, world, turn); };
+  auto updated = [&] {
+    load(state, world, turn);
+    state.map.update(turn);
+  };
+  auto& name = scenario.name;
+  bool ok = print(name, "update", measure(loaded, [&] { state.map.update(turn); }));
+  ok &= print(name, "attack", measure(updated, [&] {
+          mortido::bench::do_not_optimize(state.attack().size());
+        }));
+  // build and move_base only read the map, so the state is updated once and gold reset.
+  updated();
+  int gold = state.me.gold;
+  ok &= print(name, "build", measure([&] { state.me.gold = gold; }, [&] {
+          mortido::bench::do_not_optimize(state.build().size());
+        }));
+  ok &= print(name, "move_base", measure([] {}, [&] {
+          mortido::bench::do_not_optimize(state.move_base().has_value());
+        }));
+  return ok;
+}
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [--seed <seed>] [--turn <turn>] "
+               "[--size <n> --zombies <n> --own <n> --enemy <n> --spawns <n>]\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint32_t seed = 42;
+  int turn = 150;
+  Scenario custom{.name = "custom"};
+  bool has_custom = false;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string_view flag = argv[i];
+    auto value = static_cast<size_t>(std::strtoul(argv[i + 1], nullptr, 10));
+    if (flag == "--seed") {
+      seed = static_cast<uint32_t>(value);
+    } else if (flag == "--turn") {
+      turn = static_cast<int>(value);
+    } else if (flag == "--size") {
+      custom.size = std::max(10, static_cast<int>(value));
+    } else if (flag == "--zombies") {
+      custom.zombies = value;
+    } else if (flag == "--own") {
+      custom.own = value;
+    } else if (flag == "--enemy") {
+      custom.enemy = value;
+    } else if (flag == "--spawns") {
+      custom.spawns = value;
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    has_custom |= flag != "--seed" && flag != "--turn";
+  }
+  if (argc % 2 == 0) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<Scenario> scenarios;
+  if (has_custom) {
+    custom.size = custom.size > 0 ? custom.size : 200;
+    custom.own = std::max<size_t>(1, custom.own);
+    scenarios.push_back(custom);
+  } else {
+    // One axis at a time around "mid", plus an early and a late game.
+    scenarios = {
+        {"early", 100, 30, 20, 50, 10},           {"mid", 200, 300, 150, 500, 30},
+        {"mid-zombies-x8", 200, 2400, 150, 500, 30}, {"mid-own-x8", 200, 300, 1200, 500, 30},
+        {"mid-enemy-x8", 200, 300, 150, 4000, 30},   {"mid-spawns-x8", 200, 300, 150, 500, 240},
+        {"mid-size-300", 300, 300, 150, 500, 30},    {"late", 300, 3000, 1000, 5000, 100},
+    };
+  }
+
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+  std::printf("%-24s %-12s %10s %14s %12s %12s\n", "scenario", "phase", "iterations", "ns/op",
+              "allocs/op", "KB/op");
+  bool ok = true;
+  for (const auto& scenario : scenarios) {
+    ok &= run(scenario, seed, turn);
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
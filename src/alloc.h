@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocation counters of the current thread. They only move in binaries that include
+// alloc_hooks.h (the bot and mortido-sim when built with ALLOC_TRACKING, the benchmarks
+// always); elsewhere they stay zero and reading them is free.
+
+namespace mortido::alloc {
+
+struct Counters {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+  uint64_t frees = 0;
+
+  Counters operator-(const Counters& other) const {
+    return {allocations - other.allocations, bytes - other.bytes, frees - other.frees};
+  }
+};
+
+// Plain thread_local, no atomics: only the owning thread writes, and readers are on that
+// thread too (counters() snapshots, PERF_SCOPE deltas).
+inline thread_local Counters thread_counters;
+
+inline Counters counters() { return thread_counters; }
+
+inline void on_allocate(uint64_t size) {
+  thread_counters.allocations++;
+  thread_counters.bytes += size;
+}
+
+inline void on_free() { thread_counters.frees++; }
+
+// What the current thread allocated since construction.
+class Scope {
+ public:
+  Scope() : start_(counters()) {}
+
+  [[nodiscard]] Counters delta() const { return counters() - start_; }
+
+ private:
+  Counters start_;
+};
+
+}  // namespace mortido::alloc
@@ -0,0 +1,49 @@
+#pragma once
+
+// Counting replacements of the global allocation functions (alloc.h). They are definitions,
+// not declarations: include this from exactly one translation unit of an executable.
+// Over-aligned new/delete are left to the standard library and not counted.
+
+#include <cstdlib>
+#include <new>
+
+#include "alloc.h"
+
+namespace mortido::alloc::detail {
+
+// Out of line, so GCC does not inline a free() into callers of delete and then flag it as
+// mismatched with their new (-Wmismatched-new-delete).
+[[gnu::noinline]] inline void* raw_allocate(std::size_t size) noexcept {
+  return std::malloc(size == 0 ? 1 : size);
+}
+[[gnu::noinline]] inline void raw_free(void* p) noexcept { std::free(p); }
+
+}  // namespace mortido::alloc::detail
+
+void* operator new(std::size_t size) {
+  mortido::alloc::on_allocate(size);
+  if (void* p = mortido::alloc::detail::raw_allocate(size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  mortido::alloc::on_allocate(size);
+  return mortido::alloc::detail::raw_allocate(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+  if (p) {
+    mortido::alloc::on_free();
+  }
+  mortido::alloc::detail::raw_free(p);
+}
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { operator delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { operator delete(p); }
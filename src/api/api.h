@@ -1,9 +1,14 @@
 #pragma once
 #include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 #include <exception>
 #include <filesystem>
+#include <string>
+#include <string_view>
 
+#include "api/json_arena.h"
 #include "requests.h"
 #include "responses.h"
 
@@ -16,14 +21,53 @@ class ApiError : public std::runtime_error {
 
 class Api {
  public:
+  constexpr static size_t kDefaultMaxRetries = 50;
+
+  virtual ~Api() = default;
+
   virtual Round get_current_round(const std::string& prev_round) = 0;
   virtual ParticipateResponse participate() = 0;
   virtual CommandResponse send_command(const Command& command) = 0;
 
-  virtual rapidjson::Document get_world() = 0;
-  virtual rapidjson::Document get_units() = 0;
+  virtual JsonDocument get_world() = 0;
+  virtual JsonDocument get_units() = 0;
+  // Raw `/units` body for the SAX decoder, valid until the next call. Implementations that
+  // already hold the text should override this to skip the DOM round trip.
+  virtual std::string_view get_units_json() {
+    auto units = get_units();
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    units.Accept(writer);
+    units_json_.assign(buffer.GetString(), buffer.GetSize());
+    return units_json_;
+  }
+  // get_units_json() for callers that re-request bodies they fail to decode: `attempts` counts
+  // the attempts made so far across those calls and is never taken beyond max_retries().
+  virtual std::string_view get_units_json_within(size_t& attempts) {
+    attempts++;
+    return get_units_json();
+  }
   virtual bool active() = 0;
+  // Server wall clock minus the local system_clock in ms, against the midpoint of the request
+  // that reported it: from the last /rounds `now`, and from the Date header of the last
+  // response (whole seconds, so only good to +-500 ms per sample). nullopt where unknown.
+  [[nodiscard]] virtual std::optional<double> round_clock_offset_ms() const { return std::nullopt; }
+  [[nodiscard]] virtual std::optional<double> date_clock_offset_ms() const { return std::nullopt; }
+  // Attempts a request gets, transport errors and unparsable bodies alike.
+  [[nodiscard]] virtual size_t max_retries() const { return kDefaultMaxRetries; }
   virtual void set_dump_file(std::filesystem::path) {}
+  // Binary indexed replay written next to the text dump, see replay_file.h.
+  virtual void set_replay_file(std::filesystem::path) {}
+  // Delta-encoded dump written next to the text dump, see delta_file.h.
+  virtual void set_delta_file(std::filesystem::path) {}
+  // Documents returned afterwards allocate from `arena`, nullptr restores self-owned documents.
+  void set_json_arena(JsonArena* arena) { arena_ = arena; }
+
+ protected:
+  JsonArena* arena_ = nullptr;
+  std::string units_json_;  // backs the view returned by get_units_json()
+
+  JsonDocument make_document() { return arena_ ? arena_->make_document() : JsonDocument(); }
 };
 
 }  // namespace mortido::api
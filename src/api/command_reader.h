@@ -0,0 +1,69 @@
+#pragma once
+#include <rapidjson/document.h>
+
+#include <optional>
+#include <string_view>
+
+#include "api/requests.h"
+
+namespace mortido::api {
+
+// Parses a `/command` body back into Command, the inverse of CommandWriter. Used by the offline
+// tools that read recorded or received commands; unknown fields are ignored.
+class CommandReader {
+ public:
+  std::optional<Command> decode(std::string_view json) {
+    document_.Parse(json.data(), json.size());
+    if (document_.HasParseError() || !document_.IsObject()) {
+      return std::nullopt;
+    }
+
+    Command command;
+    if (document_.HasMember("attack") && document_["attack"].IsArray()) {
+      for (const auto& attack_val : document_["attack"].GetArray()) {
+        if (!attack_val.IsObject() || !attack_val.HasMember("blockId") ||
+            !attack_val["blockId"].IsString() || !attack_val.HasMember("target")) {
+          return std::nullopt;
+        }
+        auto target = read_position(attack_val["target"]);
+        if (!target) {
+          return std::nullopt;
+        }
+        command.attack.push_back(AttackCommand{
+            .block_id = attack_val["blockId"].GetString(),
+            .target = *target,
+            .source = {},
+        });
+      }
+    }
+    if (document_.HasMember("build") && document_["build"].IsArray()) {
+      for (const auto& build_val : document_["build"].GetArray()) {
+        auto pos = read_position(build_val);
+        if (!pos) {
+          return std::nullopt;
+        }
+        command.build.push_back(*pos);
+      }
+    }
+    if (document_.HasMember("moveBase") && !document_["moveBase"].IsNull()) {
+      command.move_base = read_position(document_["moveBase"]);
+      if (!command.move_base) {
+        return std::nullopt;
+      }
+    }
+    return command;
+  }
+
+ private:
+  rapidjson::Document document_;
+
+  static std::optional<models::vec2i> read_position(const rapidjson::Value& value) {
+    if (!value.IsObject() || !value.HasMember("x") || !value["x"].IsInt() ||
+        !value.HasMember("y") || !value["y"].IsInt()) {
+      return std::nullopt;
+    }
+    return models::vec2i{value["x"].GetInt(), value["y"].GetInt()};
+  }
+};
+
+}  // namespace mortido::api
@@ -0,0 +1,65 @@
+#pragma once
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <string_view>
+
+#include "api/requests.h"
+
+namespace mortido::api {
+
+// Serializes Command straight into a reusable buffer, no intermediate DOM. The returned view
+// is valid until the next encode() call.
+class CommandWriter {
+ public:
+  CommandWriter() : writer_(buffer_) {}
+
+  std::string_view encode(const Command& command) {
+    buffer_.Clear();
+    writer_.Reset(buffer_);
+
+    writer_.StartObject();
+    writer_.Key("attack", 6);
+    writer_.StartArray();
+    for (const auto& attack_cmd : command.attack) {
+      writer_.StartObject();
+      writer_.Key("blockId", 7);
+      writer_.String(attack_cmd.block_id.data(),
+                     static_cast<rapidjson::SizeType>(attack_cmd.block_id.size()));
+      writer_.Key("target", 6);
+      write_position(attack_cmd.target);
+      writer_.EndObject();
+    }
+    writer_.EndArray();
+
+    writer_.Key("build", 5);
+    writer_.StartArray();
+    for (const auto& build_pos : command.build) {
+      write_position(build_pos);
+    }
+    writer_.EndArray();
+
+    if (command.move_base.has_value()) {
+      writer_.Key("moveBase", 8);
+      write_position(*command.move_base);
+    }
+    writer_.EndObject();
+
+    return {buffer_.GetString(), buffer_.GetSize()};
+  }
+
+ private:
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+
+  void write_position(const models::vec2i& pos) {
+    writer_.StartObject();
+    writer_.Key("x", 1);
+    writer_.Int(pos.x);
+    writer_.Key("y", 1);
+    writer_.Int(pos.y);
+    writer_.EndObject();
+  }
+};
+
+}  // namespace mortido::api
@@ -0,0 +1,522 @@
+#include "api/delta_file.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "api/dump_format.h"
+#include "api/lz_block.h"
+#include "logger.h"
+
+namespace {
+
+using mortido::models::Building;
+using mortido::models::UnitsSnapshot;
+using mortido::models::vec2i;
+using mortido::models::Zombie;
+
+constexpr std::string_view kFileMagic = "MRTDDLT1";
+constexpr size_t kEntryHeaderSize = 5;
+constexpr size_t kMinCompressSize = 256;
+constexpr std::string_view kStateMethod = "GET";
+
+// Changed-field masks of a referenced entity.
+constexpr uint8_t kAttack = 1 << 0;
+constexpr uint8_t kHealth = 1 << 1;
+constexpr uint8_t kBlockIsHead = 1 << 2;
+constexpr uint8_t kBlockRange = 1 << 3;
+constexpr uint8_t kBlockName = 1 << 4;
+constexpr uint8_t kBlockLastAttack = 1 << 5;
+constexpr uint8_t kZombieWait = 1 << 2;
+constexpr uint8_t kZombieType = 1 << 3;
+constexpr uint8_t kZombieDirection = 1 << 4;
+constexpr uint8_t kZombieSpeed = 1 << 5;
+constexpr uint8_t kX = 1 << 6;
+constexpr uint8_t kY = 1 << 7;
+
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void put_varint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void put_sint(std::string& out, int64_t value) {
+  put_varint(out, zigzag(value));
+}
+
+void put_string(std::string& out, std::string_view value) {
+  put_varint(out, value.size());
+  out.append(value);
+}
+
+// 0 if unchanged, else size + 1 and the bytes.
+void put_string_update(std::string& out, std::string_view value, std::string_view base) {
+  if (value == base) {
+    put_varint(out, 0);
+    return;
+  }
+  put_varint(out, value.size() + 1);
+  out.append(value);
+}
+
+void put_body(std::string& out, std::string_view body) {
+  put_varint(out, body.size());
+  if (body.size() >= kMinCompressSize) {
+    std::string compressed;
+    if (mortido::api::lz_compress(body, compressed) < body.size()) {
+      put_string(out, compressed);
+      return;
+    }
+  }
+  put_string(out, body);
+}
+
+class Input {
+ public:
+  explicit Input(std::string_view data) : p_(data.data()), end_(data.data() + data.size()) {}
+
+  [[nodiscard]] size_t bytes_left() const { return static_cast<size_t>(end_ - p_); }
+
+  uint8_t byte() {
+    need(1);
+    return static_cast<uint8_t>(*p_++);
+  }
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      uint8_t b = byte();
+      value |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if ((b & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw std::runtime_error("delta file: bad varint");
+  }
+
+  int64_t sint() { return unzigzag(varint()); }
+
+  int add(int base) { return static_cast<int>(base + sint()); }
+
+  std::string_view bytes(size_t size) {
+    need(size);
+    std::string_view value(p_, size);
+    p_ += size;
+    return value;
+  }
+
+  std::string_view string() { return bytes(varint()); }
+
+  void string_update(std::string& value) {
+    if (uint64_t size = varint()) {
+      value.assign(bytes(size - 1));
+    }
+  }
+
+  void body(std::string& out) {
+    auto raw_size = varint();
+    auto stored = string();
+    if (stored.size() == raw_size) {
+      out.assign(stored);
+      return;
+    }
+    out.resize(raw_size);
+    if (!mortido::api::lz_decompress(stored, out.data(), raw_size)) {
+      throw std::runtime_error("delta file: corrupt body");
+    }
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+
+  void need(size_t size) const {
+    if (bytes_left() < size) {
+      throw std::runtime_error("delta file: truncated entry");
+    }
+  }
+};
+
+// Fields of `block` against `base` (the previous state of the same entity or a default one).
+void put_block(std::string& out, const Building& block, const Building& base) {
+  uint8_t mask = 0;
+  if (block.attack != base.attack) mask |= kAttack;
+  if (block.health != base.health) mask |= kHealth;
+  if (block.is_head != base.is_head) mask |= kBlockIsHead;
+  if (block.range != base.range) mask |= kBlockRange;
+  if (block.player_name != base.player_name) mask |= kBlockName;
+  if (block.last_attack != base.last_attack) mask |= kBlockLastAttack;
+  if (block.position.x != base.position.x) mask |= kX;
+  if (block.position.y != base.position.y) mask |= kY;
+
+  out.push_back(static_cast<char>(mask));
+  if (mask & kAttack) put_sint(out, block.attack - base.attack);
+  if (mask & kHealth) put_sint(out, block.health - base.health);
+  if (mask & kBlockRange) put_sint(out, block.range - base.range);
+  if (mask & kBlockName) put_string(out, block.player_name);
+  if (mask & kBlockLastAttack) {
+    out.push_back(block.last_attack ? 1 : 0);
+    if (block.last_attack) {
+      // Targets are within range, relative coordinates fit in a byte.
+      put_sint(out, block.last_attack->x - block.position.x);
+      put_sint(out, block.last_attack->y - block.position.y);
+    }
+  }
+  if (mask & kX) put_sint(out, block.position.x - base.position.x);
+  if (mask & kY) put_sint(out, block.position.y - base.position.y);
+}
+
+void get_block(Input& in, Building& block) {
+  uint8_t mask = in.byte();
+  if (mask & kAttack) block.attack = in.add(block.attack);
+  if (mask & kHealth) block.health = in.add(block.health);
+  if (mask & kBlockIsHead) block.is_head = !block.is_head;
+  if (mask & kBlockRange) block.range = in.add(block.range);
+  if (mask & kBlockName) block.player_name.assign(in.string());
+  std::optional<vec2i> last_attack_offset;
+  if (mask & kBlockLastAttack) {
+    if (in.byte()) {
+      int dx = static_cast<int>(in.sint());
+      last_attack_offset = vec2i(dx, static_cast<int>(in.sint()));
+    } else {
+      block.last_attack.reset();
+    }
+  }
+  if (mask & kX) block.position.x = in.add(block.position.x);
+  if (mask & kY) block.position.y = in.add(block.position.y);
+  if (last_attack_offset) {
+    block.last_attack = block.position + *last_attack_offset;
+  }
+}
+
+void put_zombie(std::string& out, const Zombie& zombie, const Zombie& base) {
+  uint8_t mask = 0;
+  if (zombie.attack != base.attack) mask |= kAttack;
+  if (zombie.health != base.health) mask |= kHealth;
+  if (zombie.wait_turns != base.wait_turns) mask |= kZombieWait;
+  if (zombie.type != base.type) mask |= kZombieType;
+  if (zombie.direction != base.direction) mask |= kZombieDirection;
+  if (zombie.speed != base.speed) mask |= kZombieSpeed;
+  if (zombie.position.x != base.position.x) mask |= kX;
+  if (zombie.position.y != base.position.y) mask |= kY;
+
+  out.push_back(static_cast<char>(mask));
+  if (mask & kAttack) put_sint(out, zombie.attack - base.attack);
+  if (mask & kHealth) put_sint(out, zombie.health - base.health);
+  if (mask & kZombieWait) put_sint(out, zombie.wait_turns - base.wait_turns);
+  if (mask & kZombieType) out.push_back(static_cast<char>(zombie.type));
+  if (mask & kZombieDirection) {
+    put_sint(out, zombie.direction.x);
+    put_sint(out, zombie.direction.y);
+  }
+  if (mask & kZombieSpeed) put_sint(out, zombie.speed - base.speed);
+  if (mask & kX) put_sint(out, zombie.position.x - base.position.x);
+  if (mask & kY) put_sint(out, zombie.position.y - base.position.y);
+}
+
+void get_zombie(Input& in, Zombie& zombie) {
+  uint8_t mask = in.byte();
+  if (mask & kAttack) zombie.attack = in.add(zombie.attack);
+  if (mask & kHealth) zombie.health = in.add(zombie.health);
+  if (mask & kZombieWait) zombie.wait_turns = in.add(zombie.wait_turns);
+  if (mask & kZombieType) {
+    uint8_t type = in.byte();
+    if (type > static_cast<uint8_t>(Zombie::Type::chaos_knight)) {
+      throw std::runtime_error("delta file: bad zombie type");
+    }
+    zombie.type = static_cast<Zombie::Type>(type);
+  }
+  if (mask & kZombieDirection) {
+    zombie.direction.x = static_cast<int>(in.sint());
+    zombie.direction.y = static_cast<int>(in.sint());
+  }
+  if (mask & kZombieSpeed) zombie.speed = in.add(zombie.speed);
+  if (mask & kX) zombie.position.x = in.add(zombie.position.x);
+  if (mask & kY) zombie.position.y = in.add(zombie.position.y);
+}
+
+// Entity list against the previous one: count, then per entity a tag (0 for a new entity
+// followed by its id, otherwise zigzag(previous index - expected index) + 1, where the expected
+// index follows the last referenced one) and its changed fields. Lists mostly keep their order
+// between turns, so most tags are 1.
+template <typename T, typename Put>
+void put_list(std::string& out, const std::vector<T>& items, const std::vector<T>& previous,
+              Put&& put_fields) {
+  static const T kEmpty{};
+  std::unordered_map<std::string_view, size_t> index;
+  put_varint(out, items.size());
+  size_t cursor = 0;
+  for (const auto& item : items) {
+    size_t found = previous.size();
+    if (cursor < previous.size() && previous[cursor].id == item.id) {
+      found = cursor;
+    } else {
+      if (index.empty()) {
+        for (size_t i = 0; i < previous.size(); i++) {
+          index.try_emplace(previous[i].id, i);
+        }
+      }
+      if (auto it = index.find(item.id); it != index.end()) {
+        found = it->second;
+      }
+    }
+
+    if (found == previous.size()) {
+      put_varint(out, 0);
+      put_string(out, item.id);
+      put_fields(out, item, kEmpty);
+      continue;
+    }
+    put_varint(out, zigzag(static_cast<int64_t>(found) - static_cast<int64_t>(cursor)) + 1);
+    put_fields(out, item, previous[found]);
+    cursor = found + 1;
+  }
+}
+
+template <typename T, typename Get, typename Init>
+void get_list(Input& in, std::vector<T>& items, const std::vector<T>& previous,
+              Get&& get_fields, Init&& init) {
+  auto count = in.varint();
+  if (count > in.bytes_left()) {
+    throw std::runtime_error("delta file: bad entity count");
+  }
+  items.resize(count);
+  size_t cursor = 0;
+  for (auto& item : items) {
+    uint64_t tag = in.varint();
+    if (tag == 0) {
+      item = T{};
+      item.id.assign(in.string());
+    } else {
+      auto found = static_cast<int64_t>(cursor) + unzigzag(tag - 1);
+      if (found < 0 || static_cast<size_t>(found) >= previous.size()) {
+        throw std::runtime_error("delta file: bad entity reference");
+      }
+      item = previous[found];
+      cursor = static_cast<size_t>(found) + 1;
+    }
+    get_fields(in, item);
+    init(item);
+  }
+}
+
+// The whole state against `base`: an empty snapshot for keyframes, the previous state for
+// deltas.
+void put_state(std::string& out, const UnitsSnapshot& units, const UnitsSnapshot& base) {
+  put_sint(out, *units.turn - base.turn.value_or(0));
+  put_sint(out, units.turn_ends_in_ms - base.turn_ends_in_ms);
+  put_string_update(out, units.player.name, base.player.name);
+  put_sint(out, units.player.gold - base.player.gold);
+  put_sint(out, units.player.enemy_block_kills - base.player.enemy_block_kills);
+  put_sint(out, units.player.points - base.player.points);
+  put_sint(out, units.player.zombie_kills - base.player.zombie_kills);
+  out.push_back(units.game_ended_at ? 1 : 0);
+  if (units.game_ended_at) {
+    put_string(out, *units.game_ended_at);
+  }
+  put_list(out, units.base, base.base, put_block);
+  put_list(out, units.enemy_blocks, base.enemy_blocks, put_block);
+  put_list(out, units.zombies, base.zombies, put_zombie);
+}
+
+void get_state(Input& in, UnitsSnapshot& units, const UnitsSnapshot& base) {
+  units.turn = in.add(base.turn.value_or(0));
+  units.turn_ends_in_ms = in.add(base.turn_ends_in_ms);
+  units.player.name = base.player.name;
+  in.string_update(units.player.name);
+  units.player.gold = in.add(base.player.gold);
+  units.player.enemy_block_kills = in.add(base.player.enemy_block_kills);
+  units.player.points = in.add(base.player.points);
+  units.player.zombie_kills = in.add(base.player.zombie_kills);
+  if (in.byte()) {
+    units.game_ended_at.emplace(in.string());
+  } else {
+    units.game_ended_at.reset();
+  }
+  auto own = [](Building& block) { block.is_enemy = false; };
+  auto enemy = [](Building& block) { block.is_enemy = true; };
+  auto none = [](Zombie&) {};
+  get_list(in, units.base, base.base, get_block, own);
+  get_list(in, units.enemy_blocks, base.enemy_blocks, get_block, enemy);
+  get_list(in, units.zombies, base.zombies, get_zombie, none);
+  units.err_code.reset();
+  units.err_message.reset();
+}
+
+}  // namespace
+
+namespace mortido::api {
+
+bool DeltaWriter::open(const std::filesystem::path& path) {
+  close();
+  file_ = std::fopen(path.c_str(), "wb");
+  if (!file_) {
+    LOG_ERROR("Could not open delta file for writing: %s", path.c_str());
+    return false;
+  }
+  std::fwrite(kFileMagic.data(), 1, kFileMagic.size(), file_);
+  since_keyframe_ = 0;
+  keyframes_ = 0;
+  deltas_ = 0;
+  has_previous_ = false;
+  return true;
+}
+
+void DeltaWriter::write(const DumpRecord& record) {
+  if (!file_) {
+    return;
+  }
+
+  payload_.clear();
+  bool is_state = record.handle == kUnitsHandle && record.method == kStateMethod &&
+                  record.request.empty() && record.http_code == 200 &&
+                  reader_.read(record.response, units_) && units_.turn && !units_.err_code &&
+                  !units_.err_message;
+  if (!is_state) {
+    put_string(payload_, record.method);
+    put_string(payload_, record.handle);
+    put_sint(payload_, record.http_code);
+    put_body(payload_, record.request);
+    put_body(payload_, record.response);
+    write_entry(DeltaKind::record);
+    return;
+  }
+
+  if (!has_previous_ || since_keyframe_ >= keyframe_interval_) {
+    put_state(payload_, units_, UnitsSnapshot{});
+    write_entry(DeltaKind::keyframe);
+    since_keyframe_ = 0;
+    keyframes_++;
+  } else {
+    put_state(payload_, units_, previous_);
+    write_entry(DeltaKind::delta);
+    deltas_++;
+  }
+  since_keyframe_++;
+  std::swap(units_, previous_);
+  has_previous_ = true;
+}
+
+void DeltaWriter::write_entry(DeltaKind kind) {
+  char header[kEntryHeaderSize];
+  header[0] = static_cast<char>(kind);
+  auto size = static_cast<uint32_t>(payload_.size());
+  std::memcpy(header + 1, &size, sizeof(size));
+  std::fwrite(header, 1, sizeof(header), file_);
+  std::fwrite(payload_.data(), 1, payload_.size(), file_);
+}
+
+void DeltaWriter::flush(bool durable) {
+  if (!file_) {
+    return;
+  }
+  std::fflush(file_);
+#ifndef _WIN32
+  if (durable) {
+    ::fsync(fileno(file_));
+  }
+#endif
+}
+
+void DeltaWriter::close() {
+  if (file_) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+DeltaReader::DeltaReader(const std::filesystem::path& path) : file_(path) {
+  data_ = file_.data();
+  if (data_.substr(0, kFileMagic.size()) != kFileMagic) {
+    throw std::runtime_error("not a delta file: " + path.string());
+  }
+  offset_ = kFileMagic.size();
+}
+
+void DeltaReader::rewind() {
+  offset_ = kFileMagic.size();
+  has_previous_ = false;
+}
+
+bool DeltaReader::next(DeltaKind& kind, DumpRecord& record, models::UnitsSnapshot& units) {
+  if (data_.size() - offset_ < kEntryHeaderSize) {
+    return false;
+  }
+  uint32_t size;
+  std::memcpy(&size, data_.data() + offset_ + 1, sizeof(size));
+  if (data_.size() - offset_ - kEntryHeaderSize < size) {
+    return false;  // torn last entry
+  }
+  auto raw_kind = static_cast<uint8_t>(data_[offset_]);
+  Input in(data_.substr(offset_ + kEntryHeaderSize, size));
+  offset_ += kEntryHeaderSize + size;
+
+  if (raw_kind == static_cast<uint8_t>(DeltaKind::record)) {
+    kind = DeltaKind::record;
+    record.method.assign(in.string());
+    record.handle.assign(in.string());
+    record.http_code = static_cast<long>(in.sint());
+    in.body(record.request);
+    in.body(record.response);
+    return true;
+  }
+  if (raw_kind == static_cast<uint8_t>(DeltaKind::keyframe)) {
+    kind = DeltaKind::keyframe;
+    get_state(in, current_, models::UnitsSnapshot{});
+  } else if (raw_kind == static_cast<uint8_t>(DeltaKind::delta) && has_previous_) {
+    kind = DeltaKind::delta;
+    get_state(in, current_, previous_);
+  } else {
+    throw std::runtime_error("delta file: unexpected entry kind " + std::to_string(raw_kind));
+  }
+  std::swap(current_, previous_);
+  has_previous_ = true;
+  units = previous_;
+
+  record.method.assign(kStateMethod);
+  record.handle.assign(kUnitsHandle);
+  record.request.clear();
+  record.http_code = 200;
+  record.response.clear();
+  return true;
+}
+
+DeltaReplay::DeltaReplay(const std::filesystem::path& path, std::optional<int> start_turn)
+    : reader_(path) {
+  if (start_turn && !seek_turn(*start_turn)) {
+    throw std::runtime_error("No turn " + std::to_string(*start_turn) +
+                             " in delta file: " + path.string());
+  }
+}
+
+bool DeltaReplay::seek_turn(int turn) {
+  DeltaKind kind;
+  while (!has_units_ || units_.turn.value_or(-1) < turn) {
+    if (!reader_.next(kind, record_, units_)) {
+      return false;
+    }
+    if (kind != DeltaKind::record) {
+      has_units_ = true;
+      units_.turn_ends_in_ms = 1;  // as DumpApi patches it
+    } else if (record_.handle == kWorldHandle) {
+      std::swap(world_json_, record_.response);
+    }
+  }
+  return true;
+}
+
+}  // namespace mortido::api
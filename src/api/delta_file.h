@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "api/dump_writer.h"
+#include "api/mapped_file.h"
+#include "models/units_reader.h"
+
+namespace mortido::api {
+
+// Delta-encoded dump, for long rounds where consecutive /units differ by a few entities:
+//   header  "MRTDDLT1"
+//   entries u8 kind, u32 payload size, payload
+//     record    any request/response that is not a /units state: method, handle, http code,
+//               request and response, the bodies lz_block encoded
+//     keyframe  a full /units state: turn fields, player, every block and zombie
+//     delta     the /units state against the previous one. Every entity is either a reference
+//               to the previous entity with the same id plus the fields that changed, or a new
+//               entity in full; entities that are gone are simply not referenced.
+// Numbers are LEB128 varints, signed values zigzag encoded, integers in deltas are differences.
+// /units bodies are kept as the state UnitsReader decodes (models::UnitsWriter turns it back
+// into JSON), not as text. A keyframe every `keyframe_interval` states bounds how far a reader
+// has to go back.
+enum class DeltaKind : uint8_t { record = 0, keyframe = 1, delta = 2 };
+
+class DeltaWriter {
+ public:
+  explicit DeltaWriter(size_t keyframe_interval = 50) : keyframe_interval_(keyframe_interval) {}
+  ~DeltaWriter() { close(); }
+
+  DeltaWriter(const DeltaWriter&) = delete;
+  DeltaWriter& operator=(const DeltaWriter&) = delete;
+
+  // Truncates `path`.
+  bool open(const std::filesystem::path& path);
+  // Successful /units responses with a turn are stored as states, the rest as plain records.
+  void write(const DumpRecord& record);
+  // Flushes buffered entries, with fsync if `durable`.
+  void flush(bool durable);
+  void close();
+
+  [[nodiscard]] bool is_open() const { return file_ != nullptr; }
+  [[nodiscard]] size_t keyframes() const { return keyframes_; }
+  [[nodiscard]] size_t deltas() const { return deltas_; }
+
+ private:
+  std::FILE* file_ = nullptr;
+  size_t keyframe_interval_;
+  size_t since_keyframe_ = 0;
+  size_t keyframes_ = 0;
+  size_t deltas_ = 0;
+  bool has_previous_ = false;
+  models::UnitsReader reader_;
+  models::UnitsSnapshot units_;
+  models::UnitsSnapshot previous_;
+  std::string payload_;
+
+  void write_entry(DeltaKind kind);
+};
+
+class DeltaReader {
+ public:
+  // Throws std::runtime_error if the file can't be read or is not a delta dump.
+  explicit DeltaReader(const std::filesystem::path& path);
+
+  // Reads the next entry: plain records into `record`, keyframes and deltas into `units` (the
+  // whole state, not the difference) with the /units request in `record` and an empty response.
+  // Throws std::runtime_error on a corrupt entry.
+  bool next(DeltaKind& kind, DumpRecord& record, models::UnitsSnapshot& units);
+  void rewind();
+
+ private:
+  MappedFile file_;
+  std::string_view data_;
+  size_t offset_ = 0;
+  bool has_previous_ = false;
+  models::UnitsSnapshot previous_;
+  models::UnitsSnapshot current_;
+};
+
+// Sequential replay of a delta dump, what tools::ReplayRunner uses for .dlt files: the /units
+// states come out as UnitsSnapshots decoded from the deltas, never through JSON, and /world
+// bodies as the recorded text. Mirrors DumpApi: a turn's state is the first one recorded with
+// at least that turn.
+class DeltaReplay {
+ public:
+  // With `start_turn` the replay begins at that turn instead of turn 0. Throws
+  // std::runtime_error if the file can't be read, is not a delta dump or has no such turn.
+  explicit DeltaReplay(const std::filesystem::path& path,
+                       std::optional<int> start_turn = std::nullopt);
+
+  // Moves to the state of `turn` (no-op if already there). False once the dump has ended.
+  bool seek_turn(int turn);
+
+  // The current state. Callers may move its entities out (State::update_from_units does).
+  [[nodiscard]] models::UnitsSnapshot& units() { return units_; }
+  // The last /world body recorded before the current state, empty if none.
+  [[nodiscard]] std::string_view world_json() const { return world_json_; }
+
+ private:
+  DeltaReader reader_;
+  DumpRecord record_;
+  models::UnitsSnapshot units_;
+  std::string world_json_;
+  bool has_units_ = false;
+};
+
+}  // namespace mortido::api
@@ -4,39 +4,35 @@
 
 #include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "api/api.h"
+#include "api/dump_format.h"
+#include "api/dump_scanner.h"
+#include "api/mapped_file.h"
 
 namespace mortido::api {
 
 class DumpApi : public Api {
  private:
   int turn_ = 0;
-  std::string last_world_json_string_;
-  std::string last_units_json_string_;
+  std::string_view last_world_json_;
+  std::string_view last_units_json_;
+  std::optional<int> last_units_turn_;
   std::filesystem::path dump_file_;
-  std::ifstream file_stream_;
+  MappedFile dump_data_;
+  size_t offset_ = 0;
   bool game_ended_ = false;
   std::string name_;
 
  public:
   explicit DumpApi(std::filesystem::path dump_file) : dump_file_(std::move(dump_file)), name_("dump_of_") {
-    file_stream_.open(dump_file_, std::ios::in);
-    if (!file_stream_.is_open()) {
-      throw std::runtime_error("Could not open dump file");
-    }
+    dump_data_ = MappedFile(dump_file_);
     name_+=dump_file_.filename().stem();
   }
 
-  ~DumpApi() {
-    if (file_stream_.is_open()) {
-      file_stream_.close();
-    }
-  }
-
   bool active() override{
     return !game_ended_ ;
   }
@@ -76,17 +72,17 @@ class DumpApi : public Api {
     return {};
   }
 
-  rapidjson::Document get_world() override {
+  JsonDocument get_world() override {
     read_turn();
-    rapidjson::Document world_doc;
-    world_doc.Parse(last_world_json_string_.c_str());
+    auto world_doc = make_document();
+    world_doc.Parse(last_world_json_.data(), last_world_json_.size());
     return world_doc;
   }
 
-  rapidjson::Document get_units() override {
+  JsonDocument get_units() override {
     read_turn();
-    rapidjson::Document units_doc;
-    units_doc.Parse(last_units_json_string_.c_str());
+    auto units_doc = make_document();
+    units_doc.Parse(last_units_json_.data(), last_units_json_.size());
     if (!units_doc.HasParseError() && units_doc.IsObject()) {
       units_doc["turnEndsInMs"] = 1;
       if (game_ended_){
@@ -99,44 +95,36 @@ class DumpApi : public Api {
   }
 
  private:
+  // One line per record: "world: <json>" or "state: <json>". Lines are found with memchr in the
+  // mapped file and kept as views, the turn of a state line is extracted once.
   void read_turn() {
-    if (!file_stream_.is_open()) {
-      file_stream_.open(dump_file_, std::ios::in);
-      if (!file_stream_.is_open()) {
-        throw std::runtime_error("Could not open dump file");
-      }
-    }
-
-    std::string line;
-    std::string type;
-    std::string json_value;
+    std::string_view data = dump_data_.data();
 
     while (true) {
-      // Parse the last known units JSON string to check the turn number
-      rapidjson::Document temp_units_doc;
-      temp_units_doc.Parse(last_units_json_string_.c_str());
-      if (!temp_units_doc.HasParseError() && temp_units_doc.HasMember("turn") &&
-          temp_units_doc["turn"].GetInt() >= turn_) {
-        turn_ = temp_units_doc["turn"].GetInt();
+      if (last_units_turn_ && *last_units_turn_ >= turn_) {
+        turn_ = *last_units_turn_;
         break;
       }
 
-      if (!std::getline(file_stream_, line)) {
+      std::string_view line;
+      if (!next_line(data, offset_, line)) {
         game_ended_ = true;
         break;
       }
 
-      std::istringstream stream(line);
-      if (!(stream >> type)) {
+      size_t space = line.find(' ');
+      if (space == std::string_view::npos) {
         continue; // Skip invalid lines
       }
 
-      json_value = line.substr(type.length() + 1); // Extract JSON part
+      std::string_view type = line.substr(0, space);
+      std::string_view json_value = line.substr(space + 1); // Extract JSON part
 
       if (type == "world:") {
-        last_world_json_string_ = json_value;
+        last_world_json_ = json_value;
       } else if (type == "state:") {
-        last_units_json_string_ = json_value;
+        last_units_json_ = json_value;
+        last_units_turn_ = find_turn(json_value);
       }
     }
   }
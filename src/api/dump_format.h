@@ -0,0 +1,125 @@
+#pragma once
+
+#include <charconv>
+#include <cstdlib>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "api/dump_writer.h"
+
+namespace mortido::api {
+
+// Text dump layout written by DumpWriter:
+//   REQUEST <method> <handle>
+//   <request body>
+//   RESPONSE <http code>
+//   <response body>
+//   ~~~~~~~~~~~~~
+constexpr std::string_view kDumpRequestFlag = "REQUEST";
+constexpr std::string_view kDumpResponseFlag = "RESPONSE";
+constexpr std::string_view kDumpEndFlag = "~~~~~~~~~~~~~";
+
+constexpr std::string_view kWorldHandle = "/play/zombidef/world";
+constexpr std::string_view kUnitsHandle = "/play/zombidef/units";
+constexpr std::string_view kCommandHandle = "/play/zombidef/command";
+
+// Value of the top-level "turn" field of a `/units` body without parsing the document. Strings
+// and nesting are tracked so a "turn" key inside a nested object is not taken for it.
+inline std::optional<int> find_turn(std::string_view json) {
+  constexpr std::string_view kKey = "turn";
+  auto skip_space = [&](size_t i) {
+    while (i < json.size() &&
+           (json[i] == ' ' || json[i] == '\t' || json[i] == '\n' || json[i] == '\r')) {
+      i++;
+    }
+    return i;
+  };
+  int depth = 0;
+  for (size_t i = 0; i < json.size(); i++) {
+    char c = json[i];
+    if (c == '{' || c == '[') {
+      depth++;
+    } else if (c == '}' || c == ']') {
+      depth--;
+    } else if (c == '"') {
+      size_t start = ++i;
+      for (; i < json.size() && json[i] != '"'; i++) {
+        if (json[i] == '\\') {
+          i++;
+        }
+      }
+      if (i >= json.size()) {
+        break;
+      }
+      if (depth != 1 || json.substr(start, i - start) != kKey) {
+        continue;
+      }
+      size_t value = skip_space(i + 1);
+      if (value >= json.size() || json[value] != ':') {
+        continue;  // a "turn" string value
+      }
+      value = skip_space(value + 1);
+      int turn = 0;
+      auto [end, ec] = std::from_chars(json.data() + value, json.data() + json.size(), turn);
+      if (ec != std::errc()) {
+        break;
+      }
+      return turn;
+    }
+  }
+  return std::nullopt;
+}
+
+inline void format_dump_record(const DumpRecord& record, std::string& out) {
+  out.append(kDumpRequestFlag).append(" ").append(record.method).append(" ").append(record.handle);
+  out.append("\n").append(record.request);
+  out.append("\n").append(kDumpResponseFlag).append(" ").append(std::to_string(record.http_code));
+  out.append("\n").append(record.response);
+  out.append("\n").append(kDumpEndFlag).append("\n");
+}
+
+// Reads the next record of a text dump. Bodies are stored without their trailing newline, so
+// formatting a record again reproduces the original bytes.
+inline bool read_dump_record(std::istream& in, DumpRecord& record, std::string& line) {
+  auto starts_with = [&line](std::string_view flag) {
+    return line.compare(0, flag.size(), flag) == 0;
+  };
+  auto read_body = [&](std::string_view flag, std::string& body) {
+    body.clear();
+    bool first = true;
+    while (std::getline(in, line)) {
+      if (starts_with(flag)) {
+        return true;
+      }
+      if (!first) {
+        body.push_back('\n');
+      }
+      body.append(line);
+      first = false;
+    }
+    return false;
+  };
+
+  while (std::getline(in, line) && !starts_with(kDumpRequestFlag)) {
+  }
+  if (!starts_with(kDumpRequestFlag)) {
+    return false;
+  }
+  size_t method_start = kDumpRequestFlag.size() + 1;
+  size_t handle_start = line.find(' ', method_start);
+  if (handle_start == std::string::npos) {
+    return false;
+  }
+  record.method.assign(line, method_start, handle_start - method_start);
+  record.handle.assign(line, handle_start + 1);
+
+  if (!read_body(kDumpResponseFlag, record.request)) {
+    return false;
+  }
+  record.http_code = std::strtol(line.c_str() + kDumpResponseFlag.size(), nullptr, 10);
+  return read_body(kDumpEndFlag, record.response);
+}
+
+}  // namespace mortido::api
@@ -0,0 +1,144 @@
+#include "api/dump_index.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "api/dump_scanner.h"
+#include "logger.h"
+
+namespace {
+
+constexpr std::string_view kIndexMagic = "MRTDTIX1";
+constexpr size_t kHeaderSize = 8 + 8 + 8 + 4;
+constexpr size_t kEntrySize = 4 + 8 + 8;
+
+template <typename T>
+void put(std::string& out, T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T get(const char* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+namespace mortido::api {
+
+DumpIndex DumpIndex::open(const std::filesystem::path& dump_file, std::string_view data) {
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(dump_file, ec);
+  int64_t dump_mtime = ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+  uint64_t dump_size = data.size();
+  auto sidecar = sidecar_path(dump_file);
+
+  DumpIndex index;
+  if (index.load(sidecar, dump_size, dump_mtime)) {
+    return index;
+  }
+  index = build(data);
+  if (!index.save(sidecar, dump_size, dump_mtime)) {
+    LOG_WARN("Could not write dump index %s", sidecar.c_str());
+  }
+  return index;
+}
+
+DumpIndex DumpIndex::build(std::string_view data) {
+  DumpIndex index;
+  DumpScanner scanner(data);
+  DumpSegment segment;
+  uint64_t world_offset = kNoOffset;
+  while (scanner.next(segment)) {
+    if (segment.handle == kWorldHandle) {
+      world_offset = segment.begin;
+    } else if (segment.turn) {
+      index.entries_.push_back(DumpTurnEntry{
+          .turn = *segment.turn,
+          .units_offset = segment.begin,
+          .world_offset = world_offset,
+      });
+    }
+  }
+  return index;
+}
+
+std::filesystem::path DumpIndex::sidecar_path(const std::filesystem::path& dump_file) {
+  auto sidecar = dump_file;
+  sidecar += ".idx";
+  return sidecar;
+}
+
+const DumpTurnEntry* DumpIndex::find(int turn) const {
+  // Dumps of several games restart the turn counter, so the entries are not sorted by turn.
+  for (const auto& entry : entries_) {
+    if (entry.turn >= turn) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+bool DumpIndex::load(const std::filesystem::path& sidecar, uint64_t dump_size,
+                     int64_t dump_mtime) {
+  std::ifstream in(sidecar, std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+  char header[kHeaderSize];
+  if (!in.read(header, kHeaderSize) ||
+      std::string_view(header, kIndexMagic.size()) != kIndexMagic ||
+      get<uint64_t>(header + 8) != dump_size || get<int64_t>(header + 16) != dump_mtime) {
+    return false;
+  }
+  uint32_t count = get<uint32_t>(header + 24);
+  std::string bytes(static_cast<size_t>(count) * kEntrySize, '\0');
+  if (!in.read(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+    return false;
+  }
+  entries_.clear();
+  entries_.reserve(count);
+  for (const char* p = bytes.data(); p < bytes.data() + bytes.size(); p += kEntrySize) {
+    entries_.push_back(DumpTurnEntry{
+        .turn = get<int32_t>(p),
+        .units_offset = get<uint64_t>(p + 4),
+        .world_offset = get<uint64_t>(p + 12),
+    });
+  }
+  return true;
+}
+
+bool DumpIndex::save(const std::filesystem::path& sidecar, uint64_t dump_size,
+                     int64_t dump_mtime) const {
+  std::string bytes;
+  bytes.reserve(kHeaderSize + entries_.size() * kEntrySize);
+  bytes.append(kIndexMagic);
+  put<uint64_t>(bytes, dump_size);
+  put<int64_t>(bytes, dump_mtime);
+  put<uint32_t>(bytes, static_cast<uint32_t>(entries_.size()));
+  for (const auto& entry : entries_) {
+    put<int32_t>(bytes, entry.turn);
+    put<uint64_t>(bytes, entry.units_offset);
+    put<uint64_t>(bytes, entry.world_offset);
+  }
+
+  // Written aside and renamed, so a concurrent reader never sees a partial index.
+  auto tmp = sidecar;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+    if (!out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()))) {
+      return false;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, sidecar, ec);
+  return !ec;
+}
+
+}  // namespace mortido::api
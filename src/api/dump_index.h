@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace mortido::api {
+
+// Where turn `turn` starts in a dump_v2 file: its `/units` segment and the last `/world`
+// segment before it.
+struct DumpTurnEntry {
+  int turn;
+  uint64_t units_offset;
+  uint64_t world_offset;  // DumpIndex::kNoOffset if no world was recorded yet
+};
+
+// Turn index of a text dump, cached next to it in `<dump>.idx`:
+//   "MRTDTIX1", u64 dump size, i64 dump mtime (ns), u32 entry count,
+//   entries {i32 turn, u64 units offset, u64 world offset}
+// The cache is rebuilt when the dump's size or mtime no longer match.
+class DumpIndex {
+ public:
+  constexpr static uint64_t kNoOffset = UINT64_MAX;
+
+  // Loads the sidecar of `dump_file` or, if it is missing or stale, scans `data` (the dump's
+  // contents) and writes a fresh one.
+  static DumpIndex open(const std::filesystem::path& dump_file, std::string_view data);
+  static DumpIndex build(std::string_view data);
+  static std::filesystem::path sidecar_path(const std::filesystem::path& dump_file);
+
+  [[nodiscard]] const std::vector<DumpTurnEntry>& entries() const { return entries_; }
+  // First entry in file order with turn >= `turn`, nullptr if there is none.
+  [[nodiscard]] const DumpTurnEntry* find(int turn) const;
+
+ private:
+  std::vector<DumpTurnEntry> entries_;
+
+  bool load(const std::filesystem::path& sidecar, uint64_t dump_size, int64_t dump_mtime);
+  bool save(const std::filesystem::path& sidecar, uint64_t dump_size, int64_t dump_mtime) const;
+};
+
+}  // namespace mortido::api
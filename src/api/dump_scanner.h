@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+#include "api/dump_format.h"
+
+namespace mortido::api {
+
+// Takes the line starting at `offset` (without its '\n') and moves `offset` past it.
+inline bool next_line(std::string_view data, size_t& offset, std::string_view& line) {
+  if (offset >= data.size()) {
+    return false;
+  }
+  const auto* found =
+      static_cast<const char*>(std::memchr(data.data() + offset, '\n', data.size() - offset));
+  size_t end = found ? static_cast<size_t>(found - data.data()) : data.size();
+  line = data.substr(offset, end - offset);
+  offset = end + 1;
+  return true;
+}
+
+// One request/response pair of a text dump. Views point into the scanned buffer, bodies come
+// without their trailing newline.
+struct DumpSegment {
+  std::string_view method;
+  std::string_view handle;
+  std::string_view request;
+  long http_code = 0;
+  std::string_view response;
+  std::optional<int> turn;  // set for `/units` responses that carry one
+
+  size_t begin = 0;  // offset of the REQUEST line
+};
+
+// Single pass scanner over an in-memory (usually mmapped, see MappedFile) text dump. Line ends
+// are located with memchr, so a body costs one vectorized search; nothing is copied and the
+// views can be parsed in place.
+class DumpScanner {
+ public:
+  DumpScanner() = default;
+  explicit DumpScanner(std::string_view data) : data_(data) {}
+
+  bool next(DumpSegment& segment) {
+    std::string_view line;
+    do {
+      segment.begin = offset_;
+      if (!next_line(line)) {
+        return false;
+      }
+    } while (!line.starts_with(kDumpRequestFlag));
+
+    line.remove_prefix(std::min(line.size(), kDumpRequestFlag.size() + 1));
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos) {
+      return false;
+    }
+    segment.method = line.substr(0, space);
+    segment.handle = line.substr(space + 1);
+
+    if (!read_body(kDumpResponseFlag, segment.request, line)) {
+      return false;
+    }
+    segment.http_code = std::strtol(line.data() + kDumpResponseFlag.size(), nullptr, 10);
+    if (!read_body(kDumpEndFlag, segment.response, line)) {
+      return false;
+    }
+
+    // Assigned whole on every segment: a reset() left GCC seeing an uninitialized payload
+    segment.turn = segment.handle == kUnitsHandle ? find_turn(segment.response) : std::nullopt;
+    return true;
+  }
+
+  [[nodiscard]] size_t offset() const { return offset_; }
+  void seek(size_t offset) { offset_ = offset; }
+  [[nodiscard]] std::string_view data() const { return data_; }
+
+ private:
+  std::string_view data_;
+  size_t offset_ = 0;
+
+  bool next_line(std::string_view& line) { return api::next_line(data_, offset_, line); }
+
+  // Body is everything up to the line starting with `flag`, which is left in `line`.
+  bool read_body(std::string_view flag, std::string_view& body, std::string_view& line) {
+    size_t begin = offset_;
+    size_t line_begin = offset_;
+    while (next_line(line)) {
+      if (line.starts_with(flag)) {
+        size_t end = line_begin > begin ? line_begin - 1 : begin;
+        body = data_.substr(begin, end - begin);
+        return true;
+      }
+      line_begin = offset_;
+    }
+    return false;
+  }
+};
+
+}  // namespace mortido::api
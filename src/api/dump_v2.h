@@ -4,42 +4,79 @@
 
 #include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
+#include <optional>
 #include <string>
+#include <string_view>
 
 #include "api/api.h"
+#include "api/dump_index.h"
+#include "api/dump_scanner.h"
+#include "api/mapped_file.h"
 
 namespace mortido::api {
 
 class DumpApi : public Api {
  private:
   int turn_ = 0;
-  std::string last_world_json_string_;
-  std::string last_units_json_string_;
+  std::string_view last_world_json_;
+  std::string_view last_units_json_;
+  std::optional<int> last_units_turn_;
   std::filesystem::path dump_file_;
-  std::ifstream file_stream_;
+  MappedFile dump_data_;
+  DumpScanner scanner_;
+  DumpSegment segment_;
+  std::optional<DumpIndex> index_;
   bool game_ended_ = false;
   std::string name_;
 
  public:
-  explicit DumpApi(std::filesystem::path dump_file)
+  // With `start_turn` the replay begins at that turn instead of turn 0, see seek_turn().
+  explicit DumpApi(std::filesystem::path dump_file, std::optional<int> start_turn = std::nullopt)
       : dump_file_(std::move(dump_file)), name_("dump_of_") {
-    file_stream_.open(dump_file_, std::ios::in);
-    if (!file_stream_.is_open()) {
-      throw std::runtime_error("Could not open dump file");
-    }
+    dump_data_ = MappedFile(dump_file_);
+    scanner_ = DumpScanner(dump_data_.data());
     name_ += dump_file_.filename().stem();
-  }
-
-  ~DumpApi() {
-    if (file_stream_.is_open()) {
-      file_stream_.close();
+    if (start_turn && !seek_turn(*start_turn)) {
+      throw std::runtime_error("No turn " + std::to_string(*start_turn) + " in dump file: " +
+                               dump_file_.string());
     }
   }
 
+  DumpApi(const DumpApi&) = delete;
+  DumpApi& operator=(const DumpApi&) = delete;
+
   bool active() override { return !game_ended_; }
 
+  // Jumps to the first recorded `/units` with turn >= `turn`: the next get_world() returns the
+  // latest `/world` before it and get_units() returns that turn. Uses the cached turn index
+  // (DumpIndex), built on the first seek.
+  bool seek_turn(int turn) {
+    if (!index_) {
+      index_ = DumpIndex::open(dump_file_, dump_data_.data());
+    }
+    const auto* entry = index_->find(turn);
+    if (entry == nullptr) {
+      return false;
+    }
+
+    last_world_json_ = {};
+    if (entry->world_offset != DumpIndex::kNoOffset) {
+      scanner_.seek(entry->world_offset);
+      if (scanner_.next(segment_)) {
+        last_world_json_ = segment_.response;
+      }
+    }
+    scanner_.seek(entry->units_offset);
+    if (!scanner_.next(segment_)) {
+      return false;
+    }
+    last_units_json_ = segment_.response;
+    last_units_turn_ = segment_.turn;
+    turn_ = entry->turn;
+    game_ended_ = false;
+    return true;
+  }
+
   Round get_current_round(const std::string& prev_round) override {
     auto now = std::chrono::system_clock::now();
     //    auto now_time_t = std::chrono::system_clock::to_time_t(now);
@@ -75,21 +112,32 @@ class DumpApi : public Api {
     return {};
   }
 
-  rapidjson::Document get_world() override {
+  JsonDocument get_world() override {
     read_turn();
-    rapidjson::Document world_doc;
-    world_doc.Parse(last_world_json_string_.c_str());
+    auto world_doc = make_document();
+    world_doc.Parse(last_world_json_.data(), last_world_json_.size());
     return world_doc;
   }
 
-  rapidjson::Document get_units() override {
+  JsonDocument get_units() override {
     read_turn();
-    rapidjson::Document units_doc;
-    units_doc.Parse(last_units_json_string_.c_str());
-    if (!units_doc.HasParseError() && units_doc.IsObject()) {
+    auto units_doc = make_document();
+    units_doc.Parse(last_units_json_.data(), last_units_json_.size());
+    // Error bodies (lobby, rate limit) carry no turn fields and are passed through.
+    if (!units_doc.HasParseError() && units_doc.IsObject() && units_doc.HasMember("turn")) {
       units_doc["turnEndsInMs"] = 1;
       if (game_ended_) {
-        units_doc["gameEndedAt"] = "seychas";
+        // State reads gameEndedAt from the player object.
+        auto& allocator = units_doc.GetAllocator();
+        if (!units_doc.HasMember("player")) {
+          units_doc.AddMember("player", rapidjson::Value(rapidjson::kObjectType), allocator);
+        }
+        auto& player = units_doc["player"];
+        if (player.HasMember("gameEndedAt")) {
+          player["gameEndedAt"] = "seychas";
+        } else {
+          player.AddMember("gameEndedAt", "seychas", allocator);
+        }
         units_doc["turn"] = turn_;
       }
     }
@@ -97,69 +145,61 @@ class DumpApi : public Api {
     return units_doc;
   }
 
- private:
-  void read_turn() {
-    if (!file_stream_.is_open()) {
-      file_stream_.open(dump_file_, std::ios::in);
-      if (!file_stream_.is_open()) {
-        throw std::runtime_error("Could not open dump file: " + dump_file_.string());
-      }
+  // Text path for the SAX decoder: the recorded body with turnEndsInMs patched in a reused
+  // buffer. The synthetic end of game is rare enough to go through the DOM.
+  std::string_view get_units_json() override {
+    read_turn();
+    if (game_ended_) {
+      return Api::get_units_json();
     }
+    units_json_.assign(last_units_json_);
+    patch_turn_ends_in_ms(units_json_);
+    return units_json_;
+  }
 
-    std::string line;
-    std::string handle;
-    std::string temp;
-
+ private:
+  // Every segment is scanned once; the turn of a `/units` body is extracted while scanning, so
+  // the loop never parses JSON.
+  void read_turn() {
     while (true) {
-      // Parse the last known units JSON string to check the turn number
-      rapidjson::Document temp_units_doc;
-      temp_units_doc.Parse(last_units_json_string_.c_str());
-      if (!temp_units_doc.HasParseError() && temp_units_doc.HasMember("turn") &&
-          temp_units_doc["turn"].GetInt() >= turn_) {
-        turn_ = temp_units_doc["turn"].GetInt();
+      if (last_units_turn_ && *last_units_turn_ >= turn_) {
+        turn_ = *last_units_turn_;
         break;
       }
 
-      if (!read_dump_segment("REQUEST", line)) {
+      if (!scanner_.next(segment_)) {
         game_ended_ = true;
         break;
       }
 
-      std::istringstream stream(line);
-      stream >> temp >> temp >> handle;
-      std::string* segment_json_ptr = nullptr;
-      if (handle == "/play/zombidef/world") {
-        segment_json_ptr = &last_world_json_string_;
-      } else if (handle == "/play/zombidef/units") {
-        segment_json_ptr = &last_units_json_string_;
-      }
-
-      if (!read_dump_segment("RESPONSE", line)) {
-        game_ended_ = true;
-        break;
-      }
-
-      if (!read_dump_segment("~~~~~~~~~~~~~", line, segment_json_ptr)) {
-        game_ended_ = true;
-        break;
+      if (segment_.handle == kWorldHandle) {
+        last_world_json_ = segment_.response;
+      } else if (segment_.handle == kUnitsHandle) {
+        last_units_json_ = segment_.response;
+        last_units_turn_ = segment_.turn;
       }
     }
   }
 
-  bool read_dump_segment(const std::string& line_flag, std::string& line,
-                         std::string* segment = nullptr) {
-    line.clear();
-    std::stringstream segment_data;
-    while (std::getline(file_stream_, line) && line.compare(0, line_flag.size(), line_flag) != 0) {
-      segment_data << line << std::endl;
+  static void patch_turn_ends_in_ms(std::string& json) {
+    constexpr std::string_view kKey = "\"turnEndsInMs\"";
+    size_t pos = json.find(kKey);
+    if (pos == std::string::npos) {
+      return;
     }
-    if (line.compare(0, line_flag.size(), line_flag) != 0) {
-      return false;
+    pos = json.find(':', pos + kKey.size());
+    if (pos == std::string::npos) {
+      return;
     }
-    if (segment != nullptr) {
-      *segment = segment_data.str();
+    size_t begin = json.find_first_not_of(" \t\n", pos + 1);
+    if (begin == std::string::npos) {
+      return;
     }
-    return true;
+    size_t end = json.find_first_not_of("-0123456789", begin);
+    if (end == std::string::npos || end == begin) {
+      return;
+    }
+    json.replace(begin, end - begin, "1");
   }
 };
 
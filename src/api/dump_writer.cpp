@@ -0,0 +1,159 @@
+#include "api/dump_writer.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "api/delta_file.h"
+#include "api/dump_format.h"
+#include "api/replay_file.h"
+#include "logger.h"
+
+namespace mortido::api {
+
+DumpWriter::DumpWriter(bool compress_replay)
+    : replay_(std::make_unique<ReplayWriter>())
+    , delta_(std::make_unique<DeltaWriter>())
+    , compress_replay_(compress_replay)
+    , last_sync_(std::chrono::steady_clock::now()) {
+  batch_.reserve(4 * 1024 * 1024);
+  thread_ = std::thread(&DumpWriter::run, this);
+}
+
+DumpWriter::~DumpWriter() {
+  stop_.store(true, std::memory_order_release);
+  thread_.join();
+  if (file_) {
+    std::fclose(file_);
+  }
+  replay_->close();
+  delta_->close();
+}
+
+bool DumpWriter::push(DumpRecord&& record) {
+  size_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+    auto deadline = std::chrono::steady_clock::now() + kMaxBackpressure;
+    while (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN("Dump writer is full, record %s %s dropped", record.method.c_str(),
+                 record.handle.c_str());
+        return false;
+      }
+      std::this_thread::yield();
+    }
+  }
+  ring_[tail & (kCapacity - 1)] = std::move(record);
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+void DumpWriter::flush() {
+  size_t target = tail_.load(std::memory_order_relaxed);
+  while (synced_.load(std::memory_order_acquire) < target) {
+    flush_requested_.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(kIdleSleep);
+  }
+}
+
+void DumpWriter::run() {
+  while (true) {
+    bool stopping = stop_.load(std::memory_order_acquire);
+    size_t written = write_batch();
+    if (written == 0) {
+      if (stopping) {
+        break;
+      }
+      std::this_thread::sleep_for(kIdleSleep);
+    }
+  }
+  sync();
+}
+
+size_t DumpWriter::write_batch() {
+  size_t head = head_.load(std::memory_order_relaxed);
+  size_t tail = tail_.load(std::memory_order_acquire);
+  if (head == tail) {
+    if (synced_.load(std::memory_order_relaxed) != head &&
+        (flush_requested_.exchange(false, std::memory_order_acq_rel) ||
+         std::chrono::steady_clock::now() - last_sync_ > kSyncInterval)) {
+      sync();
+    }
+    return 0;
+  }
+
+  size_t count = 0;
+  for (; head != tail; ++head, ++count) {
+    auto& record = ring_[head & (kCapacity - 1)];
+    if (record.file != file_name_ || record.replay_file != replay_file_name_ ||
+        record.delta_file != delta_file_name_) {
+      // All records of a batch go to the same files
+      if (count > 0) {
+        break;
+      }
+      switch_files(record);
+    }
+    if (file_) {
+      format_dump_record(record, batch_);
+    }
+    replay_->write(record);
+    delta_->write(record);
+    record = DumpRecord{};
+  }
+  if (file_ && !batch_.empty()) {
+    std::fwrite(batch_.data(), 1, batch_.size(), file_);
+    std::fflush(file_);
+  }
+  batch_.clear();
+  head_.store(head, std::memory_order_release);
+  return count;
+}
+
+void DumpWriter::sync() {
+  if (file_) {
+    std::fflush(file_);
+#ifndef _WIN32
+    ::fsync(fileno(file_));
+#endif
+  }
+  replay_->flush(true);
+  delta_->flush(true);
+  last_sync_ = std::chrono::steady_clock::now();
+  synced_.store(head_.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void DumpWriter::switch_files(const DumpRecord& record) {
+  if (record.file != file_name_) {
+    if (file_) {
+      sync();
+      std::fclose(file_);
+      file_ = nullptr;
+    }
+    file_name_ = record.file;
+    if (file_name_ && !file_name_->empty()) {
+      file_ = std::fopen(file_name_->c_str(), "a");
+      if (!file_) {
+        LOG_ERROR("Could not open error dump file for writing: %s", file_name_->c_str());
+      }
+    }
+  }
+
+  if (record.replay_file != replay_file_name_) {
+    replay_->close();
+    replay_file_name_ = record.replay_file;
+    if (replay_file_name_ && !replay_file_name_->empty()) {
+      replay_->open(*replay_file_name_, compress_replay_);
+    }
+  }
+
+  if (record.delta_file != delta_file_name_) {
+    delta_->close();
+    delta_file_name_ = record.delta_file;
+    if (delta_file_name_ && !delta_file_name_->empty()) {
+      delta_->open(*delta_file_name_);
+    }
+  }
+}
+
+}  // namespace mortido::api
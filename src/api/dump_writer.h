@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mortido::api {
+
+class DeltaWriter;
+class ReplayWriter;
+
+struct DumpRecord {
+  std::shared_ptr<const std::filesystem::path> file;
+  std::shared_ptr<const std::filesystem::path> replay_file;
+  std::shared_ptr<const std::filesystem::path> delta_file;
+  std::string handle;
+  std::string method;
+  std::string request;
+  long http_code = 0;
+  std::string response;
+};
+
+// Writes dump records from a background thread. Producer side is a lock-free single-producer
+// ring: push() only moves the record into a slot. The writer drains everything available,
+// formats it into one buffer, writes it with a single fwrite and fsyncs periodically.
+// Records with a replay_file are also appended to that binary replay (see replay_file.h), and
+// records with a delta_file to that delta dump (see delta_file.h).
+// When the ring is full push() waits up to kMaxBackpressure and then drops the record.
+class DumpWriter {
+ public:
+  constexpr static size_t kCapacity = 256;  // power of two
+  constexpr static auto kMaxBackpressure = std::chrono::milliseconds(100);
+  constexpr static auto kIdleSleep = std::chrono::milliseconds(2);
+  constexpr static auto kSyncInterval = std::chrono::seconds(1);
+
+  explicit DumpWriter(bool compress_replay = true);
+  ~DumpWriter();
+
+  DumpWriter(const DumpWriter&) = delete;
+  DumpWriter& operator=(const DumpWriter&) = delete;
+
+  // Called from one thread only. Returns false if the record was dropped.
+  bool push(DumpRecord&& record);
+
+  // Blocks until everything pushed so far is written and synced.
+  void flush();
+
+  [[nodiscard]] size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  std::array<DumpRecord, kCapacity> ring_;
+  alignas(64) std::atomic<size_t> head_{0};  // next slot to write out, owned by the writer
+  alignas(64) std::atomic<size_t> tail_{0};  // next slot to fill, owned by the producer
+  alignas(64) std::atomic<size_t> synced_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> flush_requested_{false};
+  std::atomic<size_t> dropped_{0};
+
+  std::shared_ptr<const std::filesystem::path> file_name_;
+  std::FILE* file_ = nullptr;
+  std::shared_ptr<const std::filesystem::path> replay_file_name_;
+  std::unique_ptr<ReplayWriter> replay_;
+  std::shared_ptr<const std::filesystem::path> delta_file_name_;
+  std::unique_ptr<DeltaWriter> delta_;
+  bool compress_replay_;
+  std::string batch_;
+  std::chrono::steady_clock::time_point last_sync_;
+
+  std::thread thread_;
+
+  void run();
+  size_t write_batch();
+  void sync();
+  void switch_files(const DumpRecord& record);
+};
+
+}  // namespace mortido::api
@@ -0,0 +1,178 @@
+#include "api/frame_file.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "api/lz_block.h"
+#include "logger.h"
+
+namespace {
+
+constexpr std::string_view kFileMagic = "MRTDFRM1";
+constexpr std::string_view kIndexMagic = "MRTDFIX1";
+constexpr size_t kFrameHeaderSize = 8;
+constexpr size_t kTrailerSize = 8 + 4 + 8;
+
+template <typename T>
+void put(std::string& out, T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T get(const char* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+namespace mortido::api {
+
+bool FrameWriter::open(const std::filesystem::path& path, uint16_t schema_version) {
+  close();
+  index_.clear();
+
+  std::error_code ec;
+  if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > 0) {
+    try {
+      {
+        // Unmapped before the file is truncated.
+        FrameReader existing(path);
+        if (existing.schema_version() != schema_version) {
+          LOG_ERROR("Frames %s have schema %d, not %d", path.c_str(), existing.schema_version(),
+                    schema_version);
+          return false;
+        }
+        index_ = existing.index();
+        offset_ = existing.frames_end();
+      }
+      std::filesystem::resize_file(path, offset_);
+      file_ = std::fopen(path.c_str(), "r+b");
+      if (file_) {
+        std::fseek(file_, static_cast<long>(offset_), SEEK_SET);
+      }
+    } catch (const std::runtime_error& e) {
+      LOG_ERROR("Could not append to frames %s: %s", path.c_str(), e.what());
+      return false;
+    }
+  } else {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_) {
+      buffer_.assign(kFileMagic);
+      put<uint16_t>(buffer_, schema_version);
+      std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+      offset_ = buffer_.size();
+    }
+  }
+
+  if (!file_) {
+    LOG_ERROR("Could not open frames file for writing: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void FrameWriter::write(const uint8_t* data, size_t size) {
+  if (!file_) {
+    return;
+  }
+  std::string_view raw(reinterpret_cast<const char*>(data), size);
+  buffer_.assign(kFrameHeaderSize, '\0');
+  size_t stored = lz_compress(raw, buffer_);
+  if (stored >= size) {
+    buffer_.resize(kFrameHeaderSize);
+    buffer_.append(raw);
+    stored = size;
+  }
+  auto stored_size = static_cast<uint32_t>(stored);
+  auto raw_size = static_cast<uint32_t>(size);
+  std::memcpy(buffer_.data(), &stored_size, 4);
+  std::memcpy(buffer_.data() + 4, &raw_size, 4);
+  std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+  index_.push_back(offset_);
+  offset_ += buffer_.size();
+}
+
+void FrameWriter::close() {
+  if (!file_) {
+    return;
+  }
+  buffer_.clear();
+  for (uint64_t offset : index_) {
+    put<uint64_t>(buffer_, offset);
+  }
+  put<uint64_t>(buffer_, offset_);
+  put<uint32_t>(buffer_, static_cast<uint32_t>(index_.size()));
+  buffer_.append(kIndexMagic);
+  std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+FrameReader::FrameReader(const std::filesystem::path& path) : file_(path), data_(file_.data()) {
+  if (data_.size() < kHeaderSize || data_.compare(0, kFileMagic.size(), kFileMagic) != 0) {
+    throw std::runtime_error("Not a frames file: " + path.string());
+  }
+  schema_version_ = get<uint16_t>(data_.data() + kFileMagic.size());
+  if (!load_footer()) {
+    scan();
+  }
+}
+
+bool FrameReader::load_footer() {
+  if (data_.size() < kHeaderSize + kTrailerSize ||
+      data_.compare(data_.size() - kIndexMagic.size(), kIndexMagic.size(), kIndexMagic) != 0) {
+    return false;
+  }
+  const char* trailer = data_.data() + data_.size() - kTrailerSize;
+  auto index_offset = get<uint64_t>(trailer);
+  auto count = get<uint32_t>(trailer + 8);
+  if (index_offset < kHeaderSize || index_offset + count * 8 + kTrailerSize != data_.size()) {
+    return false;
+  }
+  index_.clear();
+  index_.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    index_.push_back(get<uint64_t>(data_.data() + index_offset + i * 8));
+  }
+  frames_end_ = index_offset;
+  return true;
+}
+
+void FrameReader::scan() {
+  index_.clear();
+  uint64_t offset = kHeaderSize;
+  while (offset + kFrameHeaderSize <= data_.size()) {
+    uint64_t end = offset + kFrameHeaderSize + get<uint32_t>(data_.data() + offset);
+    if (end > data_.size()) {
+      break;  // torn last frame
+    }
+    index_.push_back(offset);
+    offset = end;
+  }
+  frames_end_ = offset;
+}
+
+bool FrameReader::frame(size_t i, std::string& out) const {
+  if (i >= index_.size()) {
+    return false;
+  }
+  const char* header = data_.data() + index_[i];
+  auto stored = get<uint32_t>(header);
+  auto raw = get<uint32_t>(header + 4);
+  if (index_[i] + kFrameHeaderSize + stored > frames_end_) {
+    return false;
+  }
+  std::string_view bytes(header + kFrameHeaderSize, stored);
+  if (stored == raw) {
+    out.assign(bytes);
+    return true;
+  }
+  out.resize(raw);
+  return lz_decompress(bytes, out.data(), raw);
+}
+
+}  // namespace mortido::api
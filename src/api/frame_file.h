@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api/mapped_file.h"
+
+namespace mortido::api {
+
+// Recorded rewind_viewer frames, written by a RewindClient frame sink (DRAW builds) and played
+// back to a viewer by mortido-frame-player:
+//   header  "MRTDFRM1", u16 viewer message schema version
+//   frames  u32 stored size, u32 raw size, stored bytes
+//           raw: the frame's size-prefixed viewer messages, exactly as sent over the socket;
+//           stored lz_block encoded when raw and stored sizes differ
+//   footer  u64 offset of every frame, u64 index offset, u32 frame count, "MRTDFIX1"
+// Integers are little-endian. A file without footer (writer crashed) is still readable, the
+// index is rebuilt by a linear scan and a torn last frame dropped.
+class FrameWriter {
+ public:
+  FrameWriter() = default;
+  ~FrameWriter() { close(); }
+
+  FrameWriter(const FrameWriter&) = delete;
+  FrameWriter& operator=(const FrameWriter&) = delete;
+
+  // Appends to an existing recording (dropping its footer or a torn last frame) or creates one.
+  bool open(const std::filesystem::path& path, uint16_t schema_version);
+  void write(const uint8_t* data, size_t size);
+  // Writes the index footer and closes the file.
+  void close();
+
+  [[nodiscard]] bool is_open() const { return file_ != nullptr; }
+  [[nodiscard]] size_t frames() const { return index_.size(); }
+
+ private:
+  std::FILE* file_ = nullptr;
+  uint64_t offset_ = 0;
+  std::vector<uint64_t> index_;
+  std::string buffer_;
+};
+
+class FrameReader {
+ public:
+  // Throws std::runtime_error if the file can't be read or is not a frame recording.
+  explicit FrameReader(const std::filesystem::path& path);
+
+  [[nodiscard]] uint16_t schema_version() const { return schema_version_; }
+  [[nodiscard]] size_t frames() const { return index_.size(); }
+  [[nodiscard]] const std::vector<uint64_t>& index() const { return index_; }
+  // Offset right after the last complete frame.
+  [[nodiscard]] uint64_t frames_end() const { return frames_end_; }
+
+  // The raw bytes of frame `i`. Returns false if it is out of range or corrupted.
+  bool frame(size_t i, std::string& out) const;
+
+  constexpr static uint64_t kHeaderSize = 10;
+
+ private:
+  MappedFile file_;
+  std::string_view data_;
+  uint16_t schema_version_ = 0;
+  std::vector<uint64_t> index_;
+  uint64_t frames_end_ = kHeaderSize;
+
+  bool load_footer();
+  void scan();
+};
+
+}  // namespace mortido::api
@@ -1,8 +1,8 @@
 #include "api/http.h"
 
 #include <rapidjson/error/en.h>
-#include <rapidjson/stringbuffer.h>
-#include <rapidjson/writer.h>
+
+#include <cctype>
 
 #include <curlpp/Easy.hpp>
 #include <curlpp/Exception.hpp>
@@ -10,9 +10,38 @@
 #include <curlpp/Options.hpp>
 
 #include "logger.h"
+#include "trace.h"
 
 using namespace std::chrono_literals;
 
+namespace {
+
+bool looks_like_json(std::string_view body) {
+  size_t start = body.find_first_not_of(" \t\r\n");
+  return start != std::string_view::npos && (body[start] == '{' || body[start] == '[');
+}
+
+// Value of a "Date:" header line, empty for any other header.
+std::string_view date_header_value(std::string_view line) {
+  constexpr std::string_view kName = "date:";
+  if (line.size() <= kName.size()) {
+    return {};
+  }
+  for (size_t i = 0; i < kName.size(); i++) {
+    if (std::tolower(static_cast<unsigned char>(line[i])) != kName[i]) {
+      return {};
+    }
+  }
+  line.remove_prefix(kName.size());
+  size_t begin = line.find_first_not_of(" \t\r\n");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  return line.substr(begin, line.find_last_not_of(" \t\r\n") + 1 - begin);
+}
+
+}  // namespace
+
 namespace mortido::api {
 
 ParticipateResponse HttpApi::participate() {
@@ -20,55 +49,32 @@ ParticipateResponse HttpApi::participate() {
   return ParticipateResponse::from_json(json_response);
 }
 
-rapidjson::Document HttpApi::get_world() {
+JsonDocument HttpApi::get_world() {
   return perform_request("/play/zombidef/world", "GET");
 }
 
-rapidjson::Document HttpApi::get_units() {
+JsonDocument HttpApi::get_units() {
   return perform_request("/play/zombidef/units", "GET");
 }
 
-CommandResponse HttpApi::send_command(const Command &command) {
-  rapidjson::Document doc;
-  doc.SetObject();
-  auto &allocator = doc.GetAllocator();
-
-  rapidjson::Value attack_array(rapidjson::kArrayType);
-  for (const auto &attack_cmd : command.attack) {
-    rapidjson::Value attack_obj(rapidjson::kObjectType);
-    attack_obj.AddMember(
-        "blockId", rapidjson::Value().SetString(attack_cmd.block_id.c_str(), allocator), allocator);
-
-    rapidjson::Value target_obj(rapidjson::kObjectType);
-    target_obj.AddMember("x", attack_cmd.target.x, allocator);
-    target_obj.AddMember("y", attack_cmd.target.y, allocator);
-
-    attack_obj.AddMember("target", target_obj, allocator);
-    attack_array.PushBack(attack_obj, allocator);
-  }
-  doc.AddMember("attack", attack_array, allocator);
-
-  rapidjson::Value build_array(rapidjson::kArrayType);
-  for (const auto &build_pos : command.build) {
-    rapidjson::Value build_obj(rapidjson::kObjectType);
-    build_obj.AddMember("x", build_pos.x, allocator);
-    build_obj.AddMember("y", build_pos.y, allocator);
-    build_array.PushBack(build_obj, allocator);
-  }
-  doc.AddMember("build", build_array, allocator);
+std::string_view HttpApi::get_units_json() {
+  size_t attempts = 0;
+  return get_units_json_within(attempts);
+}
 
-  if (command.move_base.has_value()) {
-    rapidjson::Value move_base_obj(rapidjson::kObjectType);
-    move_base_obj.AddMember("x", command.move_base->x, allocator);
-    move_base_obj.AddMember("y", command.move_base->y, allocator);
-    doc.AddMember("moveBase", move_base_obj, allocator);
+std::string_view HttpApi::get_units_json_within(size_t &attempts) {
+  const auto &body = perform_raw_request("/play/zombidef/units", "GET", {}, attempts);
+  if (!dumping()) {
+    return body;
   }
+  // The record takes the body over and is pushed on the next request, once it is parsed.
+  units_record_ = take_dump_record("/play/zombidef/units", "GET", {});
+  return units_record_->response;
+}
 
-  rapidjson::StringBuffer buffer;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-  doc.Accept(writer);
+CommandResponse HttpApi::send_command(const Command &command) {
   auto json_response =
-      perform_request("/play/zombidef/command", "POST", buffer.GetString());
+      perform_request("/play/zombidef/command", "POST", command_writer_.encode(command));
   return CommandResponse::from_json(json_response);
 }
 
@@ -85,6 +91,9 @@ Round HttpApi::get_current_round(const std::string &prev_round) {
     }
 
     auto rounds = RoundList::from_json(json_response);
+    if (rounds.precise_now) {
+      round_clock_offset_ms_ = clock_offset_ms(*rounds.precise_now);
+    }
     for (auto &round : rounds.rounds) {
       if (round.status == "active" && round.name != prev_round) {
         return round;
@@ -103,56 +112,110 @@ Round HttpApi::get_current_round(const std::string &prev_round) {
   return *next_round;
 }
 
-rapidjson::Document HttpApi::perform_request(const std::string &handle, const std::string &method,
-                                             const std::string &body) {
+JsonDocument HttpApi::perform_request(const std::string &handle, const std::string &method,
+                                      std::string_view body) {
+  TRACE_SCOPE("request", handle);
+  // One budget for transport errors and bodies that don't parse: perform_raw_request throws
+  // once it is spent.
+  size_t attempts = 0;
+  while (attempts < max_retries_) {
+    const auto &result = perform_raw_request(handle, method, body, attempts);
+
+    auto document = make_document();
+    rapidjson::ParseResult parse_result;
+    {
+      TRACE_SCOPE("json_parse", handle);
+      parse_result = document.Parse(result.data(), result.size());
+    }
+    if (dumping()) {
+      dump_writer_.push(take_dump_record(handle, method, body));
+    }
+    if (!parse_result) {
+      LOG_ERROR("JSON parse error: %s, offset: %zu",
+                rapidjson::GetParseError_En(parse_result.Code()), parse_result.Offset());
+      continue;
+    }
+    return document;
+  }
+
+  LOG_ERROR("Request was not parsed %s", handle.c_str());
+  throw ApiError("Request was not parsed");
+}
+
+const std::string &HttpApi::perform_raw_request(const std::string &handle,
+                                                const std::string &method, std::string_view body,
+                                                size_t &attempts) {
   std::string url = server_url_ + handle;
+  push_units_record();
 
-  for (size_t attempt = 0; attempt < max_retries_; ++attempt) {
+  while (attempts < max_retries_) {
+    size_t attempt = attempts++;
     LOG_DEBUG("Request to %s attempt %zu", url.c_str(), attempt);
     ensure_rate_limit();
 
+    TRACE_SCOPE("http", handle);
     try {
-      std::ostringstream response_stream;
+      response_.clear();
       curlpp::Easy request;
       request.setOpt<curlpp::options::Url>(url);
       request.setOpt<curlpp::options::HttpHeader>(headers_);
-      request.setOpt<curlpp::options::WriteStream>(&response_stream);
+      request.setOpt<curlpp::options::WriteFunction>([this](char *data, size_t size, size_t count) {
+        response_.append(data, size * count);
+        return size * count;
+      });
+      date_header_.clear();
+      request.setOpt<curlpp::options::HeaderFunction>([this](char *data, size_t size,
+                                                             size_t count) {
+        auto value = date_header_value(std::string_view(data, size * count));
+        if (!value.empty()) {
+          date_header_.assign(value);
+        }
+        return size * count;
+      });
 
+      // CURLOPT_POSTFIELDS is set on the raw handle: libcurl keeps the pointer, while
+      // curlpp::options::PostFields would copy the body into a std::string first.
+      CURL *handle_ptr = request.getCurlHandle().getHandle();
       if (method == "POST") {
-        request.setOpt<curlpp::options::PostFields>(body);
-        request.setOpt<curlpp::options::PostFieldSize>(body.length());
+        curl_easy_setopt(handle_ptr, CURLOPT_POSTFIELDS, body.data());
+        request.setOpt<curlpp::options::PostFieldSize>(static_cast<long>(body.length()));
       } else if (method == "PUT") {
         request.setOpt<curlpp::options::CustomRequest>("PUT");
         if (!body.empty()) {
-          request.setOpt<curlpp::options::PostFields>(body);
-          request.setOpt<curlpp::options::PostFieldSize>(body.length());
+          curl_easy_setopt(handle_ptr, CURLOPT_POSTFIELDS, body.data());
+          request.setOpt<curlpp::options::PostFieldSize>(static_cast<long>(body.length()));
         }
       }
+      request_sent_ = std::chrono::system_clock::now();
       request.perform();
-      auto result = response_stream.str();
+      response_received_ = std::chrono::system_clock::now();
+      if (auto date = parse_http_date(date_header_)) {
+        // The header truncates to whole seconds: the middle of that second is the best guess.
+        date_clock_offset_ms_ = clock_offset_ms(*date + 500ms);
+      }
+      const auto &result = response_;
       long http_code = curlpp::infos::ResponseCode::get(request);
+      response_code_ = http_code;
       if (http_code != 200) {
         LOG_WARN("%s HTTP response code: %ld result: %s", url.c_str(), http_code, result.c_str());
         if (http_code == 429) {
           // RPS limit
+          TRACE_INSTANT("http_429", handle);
+          continue;
+        }
+        if (!looks_like_json(result)) {
+          // Gateway error page rather than a game error, retried like a body that won't parse.
           continue;
         }
       }
 
-      dump_request(handle,method,body,http_code,result);
-
-      rapidjson::Document document;
-      rapidjson::ParseResult parse_result = document.Parse(result.c_str());
-      if (!parse_result) {
-        LOG_ERROR("JSON parse error: %s, offset: %zu",
-                  rapidjson::GetParseError_En(parse_result.Code()), parse_result.Offset());
-        continue;
-      }
-      return document;
+      return result;
     } catch (curlpp::RuntimeError &e) {
+      TRACE_INSTANT("http_error", handle);
       LOG_WARN("Runtime error on request to %s attempt %zu: %s", url.c_str(), attempt + 1,
                e.what());
     } catch (curlpp::LogicError &e) {
+      TRACE_INSTANT("http_error", handle);
       LOG_WARN("Logic error on request to %s attempt %zu: %s", url.c_str(), attempt + 1, e.what());
     }
   }
@@ -173,6 +236,7 @@ void HttpApi::ensure_rate_limit() {
   if (time_since_oldest_request < std::chrono::seconds(1)) {
     auto delay_time =
         std::chrono::seconds(1) - time_since_oldest_request + std::chrono::milliseconds(10);
+    TRACE_SCOPE("rate_limit_sleep");
     std::this_thread::sleep_for(delay_time);
   }
 
@@ -180,25 +244,36 @@ void HttpApi::ensure_rate_limit() {
   request_times_.pop();
 }
 
-void HttpApi::dump_request(const std::string &handle, const std::string &method,
-                           const std::string &request_data, long http_code,
-                           const std::string &response_data) {
-  if (dump_file_name_.empty()) {
-    return;
-  }
-  if (!dump_file_.is_open()) {
-    dump_file_.open(dump_file_name_, std::ios_base::app);
-    if (!dump_file_.is_open()) {
-      LOG_ERROR("Could not open error dump file for writing: %s", dump_file_name_.c_str());
-      return;
-    }
-  }
+double HttpApi::clock_offset_ms(std::chrono::system_clock::time_point server_time) const {
+  auto midpoint = request_sent_ + (response_received_ - request_sent_) / 2;
+  return std::chrono::duration<double, std::milli>(server_time - midpoint).count();
+}
 
-  dump_file_ << "REQUEST " << method << " " << handle << std::endl;
-  dump_file_ << request_data << std::endl;
-  dump_file_ << "RESPONSE " << http_code << std::endl;
-  dump_file_ << response_data << std::endl;
-  dump_file_ << "~~~~~~~~~~~~~" << std::endl;
+bool HttpApi::dumping() const {
+  return (dump_file_name_ && !dump_file_name_->empty()) ||
+         (replay_file_name_ && !replay_file_name_->empty()) ||
+         (delta_file_name_ && !delta_file_name_->empty());
+}
+
+DumpRecord HttpApi::take_dump_record(const std::string &handle, const std::string &method,
+                                     std::string_view request_data) {
+  return DumpRecord{
+      .file = dump_file_name_,
+      .replay_file = replay_file_name_,
+      .delta_file = delta_file_name_,
+      .handle = handle,
+      .method = method,
+      .request = std::string(request_data),
+      .http_code = response_code_,
+      .response = std::move(response_),
+  };
+}
+
+void HttpApi::push_units_record() {
+  if (units_record_) {
+    dump_writer_.push(std::move(*units_record_));
+    units_record_.reset();
+  }
 }
 
 }  // namespace mortido::api
@@ -4,13 +4,17 @@
 
 #include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <list>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <string>
+#include <string_view>
 #include <thread>
 
 #include "api/api.h"
+#include "api/command_writer.h"
+#include "api/dump_writer.h"
 
 namespace mortido::api {
 
@@ -22,12 +26,25 @@ class HttpApi : public Api {
   size_t max_retries_;
   std::list<std::string> headers_;
   std::queue<std::chrono::steady_clock::time_point> request_times_;
-  std::filesystem::path dump_file_name_;
-  std::ofstream dump_file_;
+  std::shared_ptr<const std::filesystem::path> dump_file_name_;
+  std::shared_ptr<const std::filesystem::path> replay_file_name_;
+  std::shared_ptr<const std::filesystem::path> delta_file_name_;
+  DumpWriter dump_writer_;
+  CommandWriter command_writer_;
+  std::string response_;  // body of the last response, its capacity kept between requests
+  long response_code_ = 0;
+  std::string date_header_;  // Date of the last response
+  // Local wall clock around the last request, the reference for the clock offsets.
+  std::chrono::system_clock::time_point request_sent_;
+  std::chrono::system_clock::time_point response_received_;
+  std::optional<double> round_clock_offset_ms_;
+  std::optional<double> date_clock_offset_ms_;
+  // Last /units record, its body backs the view returned by get_units_json().
+  std::optional<DumpRecord> units_record_;
 
  public:
   explicit HttpApi(std::string server_url, std::string token, size_t max_rps,
-                   size_t max_retries = 50)
+                   size_t max_retries = kDefaultMaxRetries)
       : server_url_{std::move(server_url)}
       , token_{std::move(token)}
       , max_rps_{max_rps}
@@ -36,26 +53,51 @@ class HttpApi : public Api {
     headers_.emplace_back("Accept: application/json");
   }
 
+  ~HttpApi() { push_units_record(); }
+
+  HttpApi(const HttpApi &) = delete;
+  HttpApi &operator=(const HttpApi &) = delete;
+
   ParticipateResponse participate() override;
-  rapidjson::Document get_world() override;
-  rapidjson::Document get_units() override;
+  JsonDocument get_world() override;
+  JsonDocument get_units() override;
+  std::string_view get_units_json() override;
+  std::string_view get_units_json_within(size_t &attempts) override;
   CommandResponse send_command(const Command &command) override;
   Round get_current_round(const std::string &prev_round) override;
   bool active() override { return true; }
-  void set_dump_file(std::filesystem::path file_name) override{
-    if (dump_file_.is_open()) {
-      dump_file_.close();
-    }
-    dump_file_name_ = std::move(file_name);
+  [[nodiscard]] size_t max_retries() const override { return max_retries_; }
+  [[nodiscard]] std::optional<double> round_clock_offset_ms() const override {
+    return round_clock_offset_ms_;
+  }
+  [[nodiscard]] std::optional<double> date_clock_offset_ms() const override {
+    return date_clock_offset_ms_;
+  }
+  void set_dump_file(std::filesystem::path file_name) override {
+    dump_file_name_ = std::make_shared<const std::filesystem::path>(std::move(file_name));
+  }
+  void set_replay_file(std::filesystem::path file_name) override {
+    replay_file_name_ = std::make_shared<const std::filesystem::path>(std::move(file_name));
+  }
+  void set_delta_file(std::filesystem::path file_name) override {
+    delta_file_name_ = std::make_shared<const std::filesystem::path>(std::move(file_name));
   }
 
  private:
-  rapidjson::Document perform_request(const std::string &url, const std::string &method,
-                                      const std::string &body = "");
+  JsonDocument perform_request(const std::string &url, const std::string &method,
+                               std::string_view body = {});
+  // The body is valid until the next request. Every attempt counts against `attempts`, throws
+  // ApiError once it reaches max_retries_.
+  const std::string &perform_raw_request(const std::string &handle, const std::string &method,
+                                         std::string_view body, size_t &attempts);
   void ensure_rate_limit();
-  void dump_request(const std::string &handle, const std::string &method,
-                    const std::string &request_data, long http_code,
-                    const std::string &response_data);
+  // `server_time` minus the midpoint of the last request.
+  [[nodiscard]] double clock_offset_ms(std::chrono::system_clock::time_point server_time) const;
+  [[nodiscard]] bool dumping() const;
+  // Record of the last response, which it takes over from response_.
+  DumpRecord take_dump_record(const std::string &handle, const std::string &method,
+                              std::string_view request_data);
+  void push_units_record();
 };
 
 }  // namespace mortido::api
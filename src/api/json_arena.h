@@ -0,0 +1,66 @@
+#pragma once
+#include <rapidjson/allocators.h>
+#include <rapidjson/document.h>
+
+#include <array>
+#include <memory>
+
+namespace mortido::api {
+
+using JsonAllocator = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
+// Both values and the parse stack come from pool allocators, so a document bound to a JsonArena
+// never calls malloc while the arena buffers are large enough.
+using JsonDocument = rapidjson::GenericDocument<rapidjson::UTF8<>, JsonAllocator, JsonAllocator>;
+
+// Double-buffered per-turn arena for JSON documents. Documents made during a turn stay valid
+// through the next turn; next_turn() recycles the older buffer without freeing it.
+class JsonArena {
+ public:
+  constexpr static size_t kDefaultValuesCapacity = 16 * 1024 * 1024;
+  constexpr static size_t kDefaultStackCapacity = 1024 * 1024;
+
+  explicit JsonArena(size_t values_capacity = kDefaultValuesCapacity,
+                     size_t stack_capacity = kDefaultStackCapacity)
+      : slots_{Slot(values_capacity, stack_capacity), Slot(values_capacity, stack_capacity)} {}
+
+  JsonArena(const JsonArena&) = delete;
+  JsonArena& operator=(const JsonArena&) = delete;
+
+  // O(1) unless the previous use of this slot overflowed into extra chunks.
+  void next_turn() {
+    current_ ^= 1;
+    slots_[current_].values.Clear();
+    slots_[current_].stack.Clear();
+  }
+
+  JsonDocument make_document() {
+    auto& slot = slots_[current_];
+    return JsonDocument(rapidjson::kNullType, &slot.values, kDocumentStackCapacity, &slot.stack);
+  }
+
+  // Bytes taken from the current slot, including overflow chunks.
+  [[nodiscard]] size_t used() const {
+    return slots_[current_].values.Size() + slots_[current_].stack.Size();
+  }
+
+ private:
+  constexpr static size_t kDocumentStackCapacity = 64 * 1024;
+
+  struct Slot {
+    std::unique_ptr<char[]> values_buffer;
+    std::unique_ptr<char[]> stack_buffer;
+    JsonAllocator values;
+    JsonAllocator stack;
+
+    Slot(size_t values_capacity, size_t stack_capacity)
+        : values_buffer(new char[values_capacity])
+        , stack_buffer(new char[stack_capacity])
+        , values(values_buffer.get(), values_capacity)
+        , stack(stack_buffer.get(), stack_capacity) {}
+  };
+
+  std::array<Slot, 2> slots_;
+  size_t current_ = 0;
+};
+
+}  // namespace mortido::api
@@ -0,0 +1,160 @@
+#include "api/lz_block.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMinMatch = 4;
+constexpr size_t kMaxOffset = 0xFFFF;
+constexpr unsigned kHashBits = 16;
+
+inline uint32_t read32(const char* p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t hash4(uint32_t value) { return (value * 2654435761u) >> (32 - kHashBits); }
+
+// Match finder table, allocated once per compressing thread and never cleared: a slot holds
+// base + position + 1 of a call, so anything at or below the current base is from an earlier
+// call and reads as empty.
+struct HashTable {
+  std::vector<uint32_t> slots;
+  uint32_t base = 0;
+
+  // Makes room for positions [0, n) and returns the base for this call.
+  uint32_t begin(size_t n) {
+    if (slots.empty() || n >= UINT32_MAX - base) {
+      slots.assign(size_t{1} << kHashBits, 0);
+      base = 0;
+    }
+    uint32_t current = base;
+    base += static_cast<uint32_t>(n) + 1;
+    return current;
+  }
+};
+
+void write_length(std::string& out, size_t length) {
+  while (length >= 255) {
+    out.push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  out.push_back(static_cast<char>(length));
+}
+
+void write_sequence(std::string& out, const char* literals, size_t literal_length, size_t offset,
+                    size_t match_length) {
+  size_t match_code = match_length > 0 ? match_length - kMinMatch : 0;
+  uint8_t token = static_cast<uint8_t>((literal_length < 15 ? literal_length : 15) << 4);
+  token |= static_cast<uint8_t>(match_code < 15 ? match_code : 15);
+  out.push_back(static_cast<char>(token));
+  if (literal_length >= 15) {
+    write_length(out, literal_length - 15);
+  }
+  out.append(literals, literal_length);
+  if (match_length == 0) {
+    return;
+  }
+  out.push_back(static_cast<char>(offset & 0xFF));
+  out.push_back(static_cast<char>(offset >> 8));
+  if (match_code >= 15) {
+    write_length(out, match_code - 15);
+  }
+}
+
+bool read_length(const uint8_t*& in, const uint8_t* end, size_t& length) {
+  uint8_t byte;
+  do {
+    if (in >= end) {
+      return false;
+    }
+    byte = *in++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+namespace mortido::api {
+
+size_t lz_compress(std::string_view src, std::string& out) {
+  size_t start_size = out.size();
+  const char* base = src.data();
+  size_t n = src.size();
+  thread_local HashTable table;
+  uint32_t generation = table.begin(n);
+
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (n >= kMinMatch && pos + kMinMatch <= n) {
+    uint32_t value = read32(base + pos);
+    uint32_t& slot = table.slots[hash4(value)];
+    size_t candidate = slot > generation ? slot - generation : 0;  // position + 1, 0 means empty
+    slot = generation + static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > kMaxOffset ||
+        read32(base + candidate - 1) != value) {
+      pos++;
+      continue;
+    }
+    candidate--;
+    size_t length = kMinMatch;
+    while (pos + length < n && base[candidate + length] == base[pos + length]) {
+      length++;
+    }
+    write_sequence(out, base + anchor, pos - anchor, pos - candidate, length);
+    pos += length;
+    anchor = pos;
+  }
+  write_sequence(out, base + anchor, n - anchor, 0, 0);
+  return out.size() - start_size;
+}
+
+bool lz_decompress(std::string_view src, char* dst, size_t raw_size) {
+  const auto* in = reinterpret_cast<const uint8_t*>(src.data());
+  const auto* in_end = in + src.size();
+  size_t out = 0;
+
+  while (in < in_end) {
+    uint8_t token = *in++;
+    size_t literal_length = token >> 4;
+    if (literal_length == 15 && !read_length(in, in_end, literal_length)) {
+      return false;
+    }
+    if (literal_length > static_cast<size_t>(in_end - in) || literal_length > raw_size - out) {
+      return false;
+    }
+    std::memcpy(dst + out, in, literal_length);
+    in += literal_length;
+    out += literal_length;
+    if (in == in_end) {
+      break;  // last sequence has no match
+    }
+
+    if (in_end - in < 2) {
+      return false;
+    }
+    size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+    size_t match_length = token & 0x0F;
+    if (match_length == 15 && !read_length(in, in_end, match_length)) {
+      return false;
+    }
+    match_length += kMinMatch;
+    if (offset == 0 || offset > out || match_length > raw_size - out) {
+      return false;
+    }
+    // Byte by byte: overlapping matches (offset < length) repeat the pattern
+    const char* match = dst + out - offset;
+    for (size_t i = 0; i < match_length; i++) {
+      dst[out + i] = match[i];
+    }
+    out += match_length;
+  }
+  return out == raw_size;
+}
+
+}  // namespace mortido::api
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace mortido::api {
+
+// Small LZ77 block codec (LZ4-style sequences: token, literals, 16-bit offset, match length)
+// used by the replay format. Dependency free, tuned for repetitive JSON rather than ratio.
+
+// Appends the compressed form of `src` to `out` and returns the number of bytes appended.
+size_t lz_compress(std::string_view src, std::string& out);
+
+// Decompresses exactly `raw_size` bytes into `dst`. Returns false on malformed input.
+bool lz_decompress(std::string_view src, char* dst, size_t raw_size);
+
+}  // namespace mortido::api
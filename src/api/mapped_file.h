@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace mortido::api {
+
+// Read-only view of a whole file. On POSIX the file is mmapped and pages are faulted in on
+// demand, elsewhere it falls back to reading the file into memory.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  // Throws std::runtime_error if the file can't be opened or mapped.
+  explicit MappedFile(const std::filesystem::path& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] std::string_view data() const { return {data_, size_}; }
+  [[nodiscard]] size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool mapped_ = false;
+  std::string buffer_;  // fallback storage when the file is not mapped
+
+  void reset();
+};
+
+}  // namespace mortido::api
@@ -0,0 +1,275 @@
+#include "api/replay_file.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "api/dump_format.h"
+#include "api/lz_block.h"
+#include "logger.h"
+
+namespace {
+
+constexpr std::string_view kFileMagic = "MRTDRPL1";
+constexpr std::string_view kIndexMagic = "MRTDIDX1";
+constexpr size_t kRecordHeaderSize = 32;
+constexpr size_t kIndexEntrySize = 12;
+constexpr size_t kTrailerSize = 8 + 4 + 8;
+constexpr size_t kMinCompressSize = 256;
+
+constexpr uint8_t kRequestCompressed = 1;
+constexpr uint8_t kResponseCompressed = 2;
+
+template <typename T>
+void put(std::string& out, T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  out.append(bytes, sizeof(T));
+}
+
+template <typename T>
+T get(const char* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+namespace mortido::api {
+
+bool ReplayWriter::open(const std::filesystem::path& path, bool compress) {
+  close();
+  compress_ = compress;
+  index_.clear();
+
+  std::error_code ec;
+  if (std::filesystem::exists(path, ec) && std::filesystem::file_size(path, ec) > 0) {
+    try {
+      {
+        // Unmapped before the file is truncated.
+        ReplayReader existing(path);
+        index_ = existing.index();
+        offset_ = existing.records_end();
+      }
+      std::filesystem::resize_file(path, offset_);
+      file_ = std::fopen(path.c_str(), "r+b");
+      if (file_) {
+        std::fseek(file_, static_cast<long>(offset_), SEEK_SET);
+      }
+    } catch (const std::runtime_error& e) {
+      LOG_ERROR("Could not append to replay %s: %s", path.c_str(), e.what());
+      return false;
+    }
+  } else {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_) {
+      std::fwrite(kFileMagic.data(), 1, kFileMagic.size(), file_);
+      offset_ = kFileMagic.size();
+    }
+  }
+
+  if (!file_) {
+    LOG_ERROR("Could not open replay file for writing: %s", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void ReplayWriter::write(const DumpRecord& record) {
+  if (!file_) {
+    return;
+  }
+
+  int turn = -1;
+  if (record.handle == kUnitsHandle && record.http_code == 200) {
+    if (auto found = find_turn(record.response)) {
+      turn = *found;
+      if (index_.empty() || index_.back().turn < turn) {
+        index_.push_back(ReplayIndexEntry{turn, offset_});
+      }
+    }
+  }
+
+  uint8_t flags = 0;
+  uint32_t request_stored = 0;
+  uint32_t response_stored = 0;
+  scratch_.clear();
+  scratch_.append(record.method).append(record.handle);
+  append_body(record.request, kRequestCompressed, flags, request_stored);
+  append_body(record.response, kResponseCompressed, flags, response_stored);
+
+  buffer_.clear();
+  put<uint32_t>(buffer_, static_cast<uint32_t>(kRecordHeaderSize - 4 + scratch_.size()));
+  put<uint8_t>(buffer_, flags);
+  put<uint8_t>(buffer_, static_cast<uint8_t>(record.method.size()));
+  put<uint16_t>(buffer_, static_cast<uint16_t>(record.handle.size()));
+  put<int32_t>(buffer_, static_cast<int32_t>(record.http_code));
+  put<int32_t>(buffer_, turn);
+  put<uint32_t>(buffer_, static_cast<uint32_t>(record.request.size()));
+  put<uint32_t>(buffer_, request_stored);
+  put<uint32_t>(buffer_, static_cast<uint32_t>(record.response.size()));
+  put<uint32_t>(buffer_, response_stored);
+
+  std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+  std::fwrite(scratch_.data(), 1, scratch_.size(), file_);
+  offset_ += buffer_.size() + scratch_.size();
+}
+
+void ReplayWriter::append_body(std::string_view body, uint8_t compressed_flag, uint8_t& flags,
+                               uint32_t& stored_size) {
+  if (compress_ && body.size() >= kMinCompressSize) {
+    size_t before = scratch_.size();
+    size_t compressed = lz_compress(body, scratch_);
+    if (compressed < body.size()) {
+      flags |= compressed_flag;
+      stored_size = static_cast<uint32_t>(compressed);
+      return;
+    }
+    scratch_.resize(before);
+  }
+  scratch_.append(body);
+  stored_size = static_cast<uint32_t>(body.size());
+}
+
+void ReplayWriter::flush(bool durable) {
+  if (!file_) {
+    return;
+  }
+  std::fflush(file_);
+#ifndef _WIN32
+  if (durable) {
+    ::fsync(fileno(file_));
+  }
+#endif
+}
+
+void ReplayWriter::close() {
+  if (!file_) {
+    return;
+  }
+  buffer_.clear();
+  for (const auto& entry : index_) {
+    put<int32_t>(buffer_, entry.turn);
+    put<uint64_t>(buffer_, entry.offset);
+  }
+  put<uint64_t>(buffer_, offset_);
+  put<uint32_t>(buffer_, static_cast<uint32_t>(index_.size()));
+  buffer_.append(kIndexMagic);
+  std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+  flush(true);
+  std::fclose(file_);
+  file_ = nullptr;
+}
+
+ReplayReader::ReplayReader(const std::filesystem::path& path)
+    : file_(path), data_(file_.data()) {
+  if (data_.compare(0, kFileMagic.size(), kFileMagic) != 0) {
+    throw std::runtime_error("Not a replay file: " + path.string());
+  }
+  if (!load_footer()) {
+    scan();
+  }
+}
+
+bool ReplayReader::load_footer() {
+  if (data_.size() < kHeaderSize + kTrailerSize ||
+      data_.compare(data_.size() - kIndexMagic.size(), kIndexMagic.size(), kIndexMagic) != 0) {
+    return false;
+  }
+  const char* trailer = data_.data() + data_.size() - kTrailerSize;
+  auto index_offset = get<uint64_t>(trailer);
+  auto count = get<uint32_t>(trailer + 8);
+  if (index_offset < kHeaderSize ||
+      index_offset + count * kIndexEntrySize + kTrailerSize != data_.size()) {
+    return false;
+  }
+  index_.clear();
+  index_.reserve(count);
+  const char* entry = data_.data() + index_offset;
+  for (uint32_t i = 0; i < count; i++, entry += kIndexEntrySize) {
+    index_.push_back(ReplayIndexEntry{get<int32_t>(entry), get<uint64_t>(entry + 4)});
+  }
+  records_end_ = index_offset;
+  return true;
+}
+
+void ReplayReader::scan() {
+  index_.clear();
+  uint64_t offset = kHeaderSize;
+  while (offset + kRecordHeaderSize <= data_.size()) {
+    const char* header = data_.data() + offset;
+    uint64_t end = offset + 4 + get<uint32_t>(header);
+    if (end > data_.size()) {
+      break;  // torn last record
+    }
+    auto turn = get<int32_t>(header + 12);
+    if (turn >= 0 && (index_.empty() || index_.back().turn < turn)) {
+      index_.push_back(ReplayIndexEntry{turn, offset});
+    }
+    offset = end;
+  }
+  records_end_ = offset;
+}
+
+bool ReplayReader::seek_turn(int turn) {
+  for (const auto& entry : index_) {
+    if (entry.turn >= turn) {
+      offset_ = entry.offset;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ReplayReader::next(DumpRecord& record, int& turn) {
+  if (offset_ + kRecordHeaderSize > records_end_) {
+    return false;
+  }
+  const char* header = data_.data() + offset_;
+  uint64_t end = offset_ + 4 + get<uint32_t>(header);
+  auto flags = get<uint8_t>(header + 4);
+  auto method_size = get<uint8_t>(header + 5);
+  auto handle_size = get<uint16_t>(header + 6);
+  record.http_code = get<int32_t>(header + 8);
+  turn = get<int32_t>(header + 12);
+  auto request_raw = get<uint32_t>(header + 16);
+  auto request_stored = get<uint32_t>(header + 20);
+  auto response_raw = get<uint32_t>(header + 24);
+  auto response_stored = get<uint32_t>(header + 28);
+
+  uint64_t payload = offset_ + kRecordHeaderSize;
+  if (end > records_end_ ||
+      payload + method_size + handle_size + request_stored + response_stored != end) {
+    LOG_ERROR("Corrupted replay record at offset %zu", static_cast<size_t>(offset_));
+    return false;
+  }
+  std::string_view bytes(data_.data() + payload, end - payload);
+  record.method.assign(bytes.substr(0, method_size));
+  record.handle.assign(bytes.substr(method_size, handle_size));
+  bytes.remove_prefix(method_size + handle_size);
+  if (!decode_body(bytes.substr(0, request_stored), request_raw, flags & kRequestCompressed,
+                   record.request) ||
+      !decode_body(bytes.substr(request_stored), response_raw, flags & kResponseCompressed,
+                   record.response)) {
+    LOG_ERROR("Corrupted replay body at offset %zu", static_cast<size_t>(offset_));
+    return false;
+  }
+  offset_ = end;
+  return true;
+}
+
+bool ReplayReader::decode_body(std::string_view stored, uint32_t raw_size, bool compressed,
+                               std::string& out) const {
+  if (!compressed) {
+    out.assign(stored);
+    return stored.size() == raw_size;
+  }
+  out.resize(raw_size);
+  return lz_decompress(stored, out.data(), raw_size);
+}
+
+}  // namespace mortido::api
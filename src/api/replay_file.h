@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api/dump_writer.h"
+#include "api/mapped_file.h"
+
+namespace mortido::api {
+
+// Binary replay format, an indexed alternative to the text dumps:
+//   header  "MRTDRPL1"
+//   records u32 size (of the rest of the record), u8 flags, u8 method length,
+//           u16 handle length, i32 http code, i32 turn (-1 unless a /units response),
+//           u32 request raw/stored length, u32 response raw/stored length,
+//           method, handle, request, response
+//   footer  index entries {i32 turn, u64 offset of the turn's /units record},
+//           u64 index offset, u32 entry count, "MRTDIDX1"
+// Bodies flagged as compressed are lz_block encoded. Integers are little-endian. A file without
+// footer (writer crashed) is still readable, the index is rebuilt by a linear scan.
+struct ReplayIndexEntry {
+  int turn;
+  uint64_t offset;
+};
+
+class ReplayWriter {
+ public:
+  ReplayWriter() = default;
+  ~ReplayWriter() { close(); }
+
+  ReplayWriter(const ReplayWriter&) = delete;
+  ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+  // Appends to an existing replay (dropping its footer or a torn last record) or creates one.
+  bool open(const std::filesystem::path& path, bool compress);
+  void write(const DumpRecord& record);
+  // Flushes buffered records, with fsync if `durable`.
+  void flush(bool durable);
+  // Writes the index footer and closes the file.
+  void close();
+
+  [[nodiscard]] bool is_open() const { return file_ != nullptr; }
+
+ private:
+  std::FILE* file_ = nullptr;
+  uint64_t offset_ = 0;
+  bool compress_ = false;
+  std::vector<ReplayIndexEntry> index_;
+  std::string buffer_;
+  std::string scratch_;
+
+  void append_body(std::string_view body, uint8_t compressed_flag, uint8_t& flags,
+                   uint32_t& stored_size);
+};
+
+class ReplayReader {
+ public:
+  // Throws std::runtime_error if the file can't be read or is not a replay.
+  explicit ReplayReader(const std::filesystem::path& path);
+
+  [[nodiscard]] const std::vector<ReplayIndexEntry>& index() const { return index_; }
+  // Offset right after the last complete record.
+  [[nodiscard]] uint64_t records_end() const { return records_end_; }
+
+  // Positions the reader at the /units record of the first indexed turn >= `turn`.
+  bool seek_turn(int turn);
+  void rewind() { offset_ = kHeaderSize; }
+
+  // Reads the next record, `turn` is set for /units responses and -1 otherwise.
+  bool next(DumpRecord& record, int& turn);
+
+  constexpr static uint64_t kHeaderSize = 8;
+
+ private:
+  MappedFile file_;
+  std::string_view data_;
+  std::vector<ReplayIndexEntry> index_;
+  uint64_t records_end_ = kHeaderSize;
+  uint64_t offset_ = kHeaderSize;
+
+  bool load_footer();
+  void scan();
+  bool decode_body(std::string_view stored, uint32_t raw_size, bool compressed,
+                   std::string& out) const;
+};
+
+}  // namespace mortido::api
@@ -1,7 +1,10 @@
 #include "responses.h"
 
+#include <cctype>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <locale>
 #include <sstream>
 
 namespace {
@@ -17,6 +20,36 @@ std::chrono::system_clock::time_point parse_system_time(const std::string& time_
   return time_point;
 }
 
+std::time_t utc_time(std::tm& tm) {
+#ifdef _WIN32
+  return _mkgmtime(&tm);
+#else
+  return timegm(&tm);
+#endif
+}
+
+// Like parse_system_time, but keeps the fraction of a second and reads a 'Z' suffixed time as
+// UTC (without one it is local time, as parse_system_time takes every timestamp).
+std::optional<std::chrono::system_clock::time_point> parse_precise_time(
+    const std::string& time_str) {
+  std::tm tm = {};
+  std::istringstream ss(time_str);
+  ss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+  if (ss.fail()) {
+    return std::nullopt;
+  }
+  std::chrono::nanoseconds fraction{0};
+  if (ss.peek() == '.') {
+    ss.get();
+    for (int64_t scale = 100'000'000; std::isdigit(ss.peek()); scale /= 10) {
+      fraction += std::chrono::nanoseconds((ss.get() - '0') * scale);
+    }
+  }
+  std::time_t time = ss.peek() == 'Z' ? utc_time(tm) : std::mktime(&tm);
+  return std::chrono::system_clock::from_time_t(time) +
+         std::chrono::duration_cast<std::chrono::system_clock::duration>(fraction);
+}
+
 }  // namespace
 
 namespace mortido::api {
@@ -35,6 +68,7 @@ RoundList RoundList::from_json(const rapidjson::Value& value) {
   RoundList round_list;
   round_list.game_name = value["gameName"].GetString();
   round_list.now = parse_system_time(value["now"].GetString());
+  round_list.precise_now = parse_precise_time(value["now"].GetString());
   if (value.HasMember("rounds") && value["rounds"].IsArray()) {
     for (const auto& round_val : value["rounds"].GetArray()) {
       auto& round = round_list.rounds.emplace_back(Round::from_json(round_val));
@@ -80,4 +114,15 @@ ParticipateResponse ParticipateResponse::from_json(const rapidjson::Value& value
   return response;
 }
 
+std::optional<std::chrono::system_clock::time_point> parse_http_date(std::string_view text) {
+  std::tm tm = {};
+  std::istringstream ss{std::string(text)};
+  ss.imbue(std::locale::classic());
+  ss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+  if (ss.fail()) {
+    return std::nullopt;
+  }
+  return std::chrono::system_clock::from_time_t(utc_time(tm));
+}
+
 }  // namespace mortido::models
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "rapidjson/document.h"
@@ -23,6 +24,8 @@ struct Round {
 struct RoundList {
   std::string game_name;
   std::chrono::system_clock::time_point now;
+  // `now` with its fraction of a second, for measuring the server clock offset.
+  std::optional<std::chrono::system_clock::time_point> precise_now;
   std::vector<Round> rounds;
 
   static RoundList from_json(const rapidjson::Value& value);
@@ -46,4 +49,7 @@ struct CommandResponse {
   static CommandResponse from_json(const rapidjson::Value& value) { return {}; }
 };
 
+// RFC 7231 HTTP-date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT". nullopt if malformed.
+std::optional<std::chrono::system_clock::time_point> parse_http_date(std::string_view text);
+
 }  // namespace mortido::models
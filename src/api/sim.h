@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "api/api.h"
+#include "sim/engine.h"
+
+namespace mortido::api {
+
+// Offline game against the local engine (sim/engine.h): every send_command() advances the
+// world by one turn, so a whole game runs as fast as the strategy decides. Bodies have the
+// server's shape, but the simulated rules are an approximation and there is no fog of war.
+class SimApi : public Api {
+ private:
+  sim::Engine engine_;
+  std::string world_json_;
+  std::chrono::steady_clock::duration engine_time_{};
+  bool check_index_ = false;
+  std::optional<int> broken_index_turn_;
+
+  template <typename F>
+  void timed(F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    engine_time_ += std::chrono::steady_clock::now() - start;
+  }
+
+ public:
+  explicit SimApi(const sim::Config& config = {}) : engine_(config) {}
+
+  SimApi(const SimApi&) = delete;
+  SimApi& operator=(const SimApi&) = delete;
+
+  [[nodiscard]] const sim::Engine& engine() const { return engine_; }
+  // Time spent stepping the engine and writing its bodies, the rest of a game is the bot.
+  [[nodiscard]] std::chrono::steady_clock::duration engine_time() const { return engine_time_; }
+
+  // Verifies the engine's zombie index after every step (sim::Engine::zombie_index_valid),
+  // broken_index_turn() is the first turn it failed on.
+  void set_check_index(bool check) { check_index_ = check; }
+  [[nodiscard]] std::optional<int> broken_index_turn() const { return broken_index_turn_; }
+
+  bool active() override { return !engine_.ended(); }
+
+  Round get_current_round(const std::string&) override {
+    auto now = std::chrono::system_clock::now();
+    Round round;
+    round.duration = 0;
+    round.end_at = now;
+    round.now = now;
+    round.name = engine_.name();
+    round.start_at = now;
+    round.status = "active";
+    return round;
+  }
+
+  ParticipateResponse participate() override {
+    return ParticipateResponse{
+        .registered = true,
+        .starts_in_sec = 0,
+    };
+  }
+
+  CommandResponse send_command(const Command& command) override {
+    timed([&] { engine_.step(command); });
+    if (check_index_ && !broken_index_turn_ && !engine_.zombie_index_valid()) {
+      broken_index_turn_ = engine_.turn();
+    }
+    return {};
+  }
+
+  JsonDocument get_world() override {
+    timed([&] { engine_.write_world(world_json_); });
+    auto world_doc = make_document();
+    world_doc.Parse(world_json_.data(), world_json_.size());
+    return world_doc;
+  }
+
+  JsonDocument get_units() override {
+    timed([&] { engine_.write_units(units_json_); });
+    auto units_doc = make_document();
+    units_doc.Parse(units_json_.data(), units_json_.size());
+    return units_doc;
+  }
+
+  std::string_view get_units_json() override {
+    timed([&] { engine_.write_units(units_json_); });
+    return units_json_;
+  }
+};
+
+}  // namespace mortido::api
@@ -0,0 +1,411 @@
+#include "async_log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mortido::logging {
+
+namespace {
+
+using detail::Header;
+using detail::Tag;
+
+// Per thread ring of variable-size records. head is only written by the owning thread, tail
+// only by whoever holds the drain mutex.
+struct Ring {
+  constexpr static size_t kCapacity = 1 << 20;
+
+  std::unique_ptr<uint8_t[]> data = std::make_unique<uint8_t[]>(kCapacity);
+  std::atomic<uint64_t> head{0};
+  std::atomic<uint64_t> tail{0};
+  uint64_t reserved_at = 0;  // owner only
+  char thread_name[LOGURU_THREADNAME_WIDTH + 1] = {};
+};
+
+struct Pending {
+  uint64_t seq;
+  size_t ring;  // index into the drain's ring snapshot
+  uint64_t pos;
+  uint32_t size;
+};
+
+enum class Drain {
+  ordered,     // stop at the first sequence gap: a record being committed on another thread
+  everything,  // gaps included, for stop() and crash flushes
+};
+
+class Backend {
+ public:
+  static Backend& instance() {
+    static Backend backend;
+    return backend;
+  }
+
+  Ring& thread_ring() {
+    thread_local std::shared_ptr<Ring> ring = [this] {
+      auto created = std::make_shared<Ring>();
+      loguru::get_thread_name(created->thread_name, sizeof(created->thread_name), true);
+      std::lock_guard lock(rings_mutex_);
+      rings_.push_back(created);
+      return created;
+    }();
+    return *ring;
+  }
+
+  uint8_t* reserve(size_t size) {
+    auto& ring = thread_ring();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    size_t offset = head % Ring::kCapacity;
+    size_t skip = offset + size > Ring::kCapacity ? Ring::kCapacity - offset : 0;
+    while (head + skip + size - ring.tail.load(std::memory_order_acquire) > Ring::kCapacity) {
+      if (running_.load(std::memory_order_relaxed)) {
+        wake_.notify_one();
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      } else {
+        drain(false, Drain::everything);
+      }
+    }
+    if (skip >= sizeof(Header)) {
+      Header wrap{};  // size 0: continue at the ring start
+      std::memcpy(ring.data.get() + offset, &wrap, sizeof(wrap));
+    }
+    ring.reserved_at = head + skip;
+    return ring.data.get() + ring.reserved_at % Ring::kCapacity;
+  }
+
+  void commit(size_t size) {
+    auto& ring = thread_ring();
+    uint64_t seq = seq_.fetch_add(1, std::memory_order_relaxed);
+    std::memcpy(ring.data.get() + ring.reserved_at % Ring::kCapacity + offsetof(Header, seq), &seq,
+                sizeof(seq));
+    ring.head.store(ring.reserved_at + size, std::memory_order_release);
+    if (ring.reserved_at + size - ring.tail.load(std::memory_order_relaxed) >
+        Ring::kCapacity / 2) {
+      wake_.notify_one();
+    }
+  }
+
+  void start() {
+    std::lock_guard lock(control_mutex_);
+    if (running_) {
+      return;
+    }
+    loguru::add_callback(kCallbackId, [](void*, const loguru::Message&) {}, nullptr,
+                         loguru::Verbosity_FATAL, nullptr,
+                         [](void*) { Backend::instance().drain(true, Drain::everything); });
+    running_ = true;
+    writer_ = std::thread([this] {
+      loguru::set_thread_name("async log");
+      while (running_.load(std::memory_order_relaxed)) {
+        {
+          std::unique_lock lock(wake_mutex_);
+          wake_.wait_for(lock, std::chrono::milliseconds(20));
+        }
+        drain(false, Drain::ordered);
+      }
+    });
+    detail::enabled.store(true, std::memory_order_relaxed);
+  }
+
+  void stop() {
+    std::lock_guard lock(control_mutex_);
+    if (!running_) {
+      return;
+    }
+    detail::enabled.store(false, std::memory_order_relaxed);
+    running_ = false;
+    wake_.notify_one();
+    writer_.join();
+    drain(false, Drain::everything);
+    loguru::remove_callback(kCallbackId);
+  }
+
+  // Writes out pending records in sequence order. Sequence numbers are taken in commit(), just
+  // before the record is published, so a record can still be missing from its ring while a
+  // later one is visible on another: an ordered drain stops at such a gap and leaves the rest
+  // for the next pass. Returns false if it did.
+  //
+  // `from_loguru`: called back from loguru::flush(), possibly in a crash handler holding
+  // loguru's lock. Then the drain lock is waited for at most kCrashDrainWait and never
+  // re-entered.
+  bool drain(bool from_loguru, Drain mode) {
+    thread_local bool draining = false;
+    if (draining) {
+      return true;
+    }
+    std::unique_lock lock(drain_mutex_, std::defer_lock);
+    if (from_loguru) {
+      if (!lock.try_lock_for(kCrashDrainWait)) {
+        return false;
+      }
+    } else {
+      lock.lock();
+    }
+    draining = true;
+
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+      std::lock_guard rings_lock(rings_mutex_);
+      rings = rings_;
+    }
+    pending_.clear();
+    tails_.clear();
+    for (size_t r = 0; r < rings.size(); r++) {
+      auto& ring = *rings[r];
+      uint64_t head = ring.head.load(std::memory_order_acquire);
+      uint64_t pos = ring.tail.load(std::memory_order_relaxed);
+      tails_.push_back(pos);
+      while (pos < head) {
+        size_t offset = pos % Ring::kCapacity;
+        Header header;
+        if (Ring::kCapacity - offset >= sizeof(Header)) {
+          std::memcpy(&header, ring.data.get() + offset, sizeof(header));
+        }
+        if (Ring::kCapacity - offset < sizeof(Header) || header.size == 0) {
+          pos += Ring::kCapacity - offset;
+          continue;
+        }
+        pending_.push_back(Pending{header.seq, r, pos, header.size});
+        pos += header.size;
+      }
+    }
+    std::sort(pending_.begin(), pending_.end(),
+              [](const Pending& a, const Pending& b) { return a.seq < b.seq; });
+    bool complete = true;
+    for (const auto& record : pending_) {
+      if (mode == Drain::ordered && record.seq > next_seq_) {
+        complete = false;
+        break;
+      }
+      write(*rings[record.ring], record.pos);
+      next_seq_ = std::max(next_seq_, record.seq + 1);  // below only after a forced drain
+      tails_[record.ring] = record.pos + record.size;
+    }
+    for (size_t r = 0; r < rings.size(); r++) {
+      rings[r]->tail.store(tails_[r], std::memory_order_release);
+    }
+    draining = false;
+    return complete;
+  }
+
+ private:
+  constexpr static const char* kCallbackId = "mortido-async-log";
+  // Longest a loguru::flush() callback (LOG_FATAL, crash handlers) waits for a drain pass in
+  // progress. It only waits while another pass holds the lock, normally the writer thread's
+  // for well under a millisecond; the full wait only if that pass never finishes, e.g. when
+  // the crash interrupted it, and then pending records are lost rather than deadlocking.
+  constexpr static auto kCrashDrainWait = std::chrono::milliseconds(100);
+
+  std::mutex control_mutex_;
+  std::atomic<bool> running_{false};
+  std::thread writer_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+  std::atomic<uint64_t> seq_{0};
+  const int64_t start_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+
+  std::mutex rings_mutex_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+
+  // Drain state, reused between passes.
+  std::timed_mutex drain_mutex_;
+  std::vector<Pending> pending_;
+  std::vector<uint64_t> tails_;
+  uint64_t next_seq_ = 0;  // first sequence number not written yet
+  std::string text_;
+  std::string spec_;
+  std::string arg_text_;
+
+  struct Arg {
+    Tag tag;
+    uint64_t bits;
+    std::string_view text;
+  };
+
+  // Formats one record with loguru's preamble layout and passes it to loguru unchanged.
+  void write(const Ring& ring, uint64_t pos) {
+    const uint8_t* record = ring.data.get() + pos % Ring::kCapacity;
+    Header header;
+    std::memcpy(&header, record, sizeof(header));
+    const uint8_t* in = record + sizeof(Header);
+    const uint8_t* end = record + header.size;
+
+    text_.clear();
+    auto verbosity = static_cast<loguru::Verbosity>(header.verbosity);
+    append_preamble(header, ring.thread_name, verbosity);
+    auto next_arg = [&](Arg& arg) {
+      if (in >= end) {
+        return false;
+      }
+      arg.tag = static_cast<Tag>(*in++);
+      if (arg.tag == Tag::str) {
+        uint32_t length;
+        std::memcpy(&length, in, sizeof(length));
+        in += sizeof(length);
+        arg.text = {reinterpret_cast<const char*>(in), length};
+        in += length;
+      } else {
+        std::memcpy(&arg.bits, in, sizeof(arg.bits));
+        in += sizeof(arg.bits);
+      }
+      return true;
+    };
+    format_message(header.format, next_arg);
+    loguru::raw_log(verbosity, header.file, header.line, "%s", text_.c_str());
+  }
+
+  void append_preamble(const Header& header, const char* thread_name,
+                       loguru::Verbosity verbosity) {
+    if (!loguru::g_preamble) {
+      return;
+    }
+    auto seconds = static_cast<time_t>(header.wall_ns / 1000000000);
+    tm time_info{};
+    localtime_r(&seconds, &time_info);
+    const char* file = std::strrchr(header.file, '/');
+    file = file ? file + 1 : header.file;
+    char level[6];
+    if (const char* name = loguru::get_verbosity_name(verbosity)) {
+      std::snprintf(level, sizeof(level), "%s", name);
+    } else {
+      std::snprintf(level, sizeof(level), "% 4d", static_cast<int8_t>(verbosity));
+    }
+    char preamble[160];
+    std::snprintf(preamble, sizeof(preamble),
+                  "%04d-%02d-%02d %02d:%02d:%02d.%03d (%8.3fs) [%-*s]%*.*s:%-5u %4s| ",
+                  1900 + time_info.tm_year, 1 + time_info.tm_mon, time_info.tm_mday,
+                  time_info.tm_hour, time_info.tm_min, time_info.tm_sec,
+                  static_cast<int>(header.wall_ns / 1000000 % 1000),
+                  static_cast<double>(header.wall_ns - start_ns_) / 1e9, LOGURU_THREADNAME_WIDTH,
+                  thread_name, LOGURU_FILENAME_WIDTH, LOGURU_FILENAME_WIDTH, file, header.line,
+                  level);
+    text_ += preamble;
+  }
+
+  template <typename T>
+  void append(const char* spec, T value) {
+    int length = std::snprintf(nullptr, 0, spec, value);
+    if (length <= 0) {
+      return;
+    }
+    size_t at = text_.size();
+    text_.resize(at + static_cast<size_t>(length) + 1);
+    std::snprintf(text_.data() + at, static_cast<size_t>(length) + 1, spec, value);
+    text_.resize(at + static_cast<size_t>(length));
+  }
+
+  // printf semantics over the recorded arguments: every conversion is re-run through snprintf
+  // with its flags, width and precision, the length modifier replaced by the recorded width.
+  template <typename NextArg>
+  void format_message(const char* format, NextArg& next_arg) {
+    Arg arg{};
+    for (const char* p = format; *p; p++) {
+      if (*p != '%') {
+        text_ += *p;
+        continue;
+      }
+      if (p[1] == '%') {
+        text_ += '%';
+        p++;
+        continue;
+      }
+      spec_.assign(1, '%');
+      for (p++; *p && std::strchr("-+ #0", *p); p++) spec_ += *p;
+      auto width = [&] {
+        if (*p == '*') {
+          spec_ += next_arg(arg) ? std::to_string(static_cast<int>(arg.bits)) : "";
+          p++;
+        }
+        for (; *p >= '0' && *p <= '9'; p++) spec_ += *p;
+      };
+      width();
+      if (*p == '.') {
+        spec_ += *p++;
+        width();
+      }
+      while (*p && std::strchr("hlLqjzt", *p)) p++;
+      char conversion = *p;
+      if (!conversion) {
+        break;
+      }
+      if (conversion == 'n') {
+        continue;
+      }
+      if (!next_arg(arg)) {
+        text_ += "<?>";
+        continue;
+      }
+      switch (conversion) {
+        case 'd':
+        case 'i':
+          spec_ += "lld";
+          append(spec_.c_str(), static_cast<long long>(arg.bits));
+          break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+          spec_ += "ll";
+          spec_ += conversion;
+          append(spec_.c_str(), static_cast<unsigned long long>(arg.bits));
+          break;
+        case 'c':
+          spec_ += 'c';
+          append(spec_.c_str(), static_cast<int>(arg.bits));
+          break;
+        case 's':
+          spec_ += 's';
+          if (arg.tag == Tag::str) {
+            arg_text_.assign(arg.text);
+            append(spec_.c_str(), arg_text_.c_str());
+          } else {
+            text_ += "<?>";
+          }
+          break;
+        case 'p':
+          spec_ += 'p';
+          append(spec_.c_str(), reinterpret_cast<void*>(static_cast<uintptr_t>(arg.bits)));
+          break;
+        default: {  // f, e, g, a and upper case variants
+          double value;
+          std::memcpy(&value, &arg.bits, sizeof(value));
+          spec_ += conversion;
+          append(spec_.c_str(), arg.tag == Tag::f64 ? value : static_cast<double>(arg.bits));
+        }
+      }
+    }
+  }
+};
+
+}  // namespace
+
+namespace detail {
+
+uint8_t* reserve(size_t size) { return Backend::instance().reserve(size); }
+void commit(size_t size) { Backend::instance().commit(size); }
+
+}  // namespace detail
+
+void start() { Backend::instance().start(); }
+void stop() { Backend::instance().stop(); }
+void flush() {
+  // A gap closes as soon as the other thread's commit() finishes
+  for (int attempt = 0; attempt < 100; attempt++) {
+    if (Backend::instance().drain(false, Drain::ordered)) {
+      return;
+    }
+    std::this_thread::yield();
+  }
+  Backend::instance().drain(false, Drain::everything);
+}
+
+}  // namespace mortido::logging
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Asynchronous backend for the logger.h macros. While started, a log call only copies the
+// format string pointer (its id), file, line and the raw arguments into a ring buffer owned by
+// the calling thread; a background thread formats the records and hands them to loguru, so the
+// existing sinks (stderr, add_file) keep working with the game thread out of the I/O.
+//
+// Records leave in the order they were published, across threads too. Everything pending is
+// written out by flush() and stop(), before LOG_FATAL, and on loguru::flush(), which loguru
+// also calls from its crash signal handler. That last path waits at most 100 ms for a drain
+// already in progress on another thread (kCrashDrainWait in async_log.cpp).
+
+namespace mortido::logging {
+
+namespace detail {
+
+enum class Tag : uint8_t { i64, u64, f64, str, ptr };
+
+inline std::atomic<bool> enabled{false};
+
+struct Header {
+  uint64_t seq;
+  int64_t wall_ns;  // system_clock, for the preamble
+  const char* format;
+  const char* file;
+  uint32_t line;
+  int32_t verbosity;
+  uint32_t size;  // whole record, header included; 0 marks the wrap to the ring start
+};
+
+// Largest record; longer string arguments are truncated to fit.
+constexpr size_t kMaxRecord = 16 * 1024;
+
+// Reserves `size` contiguous bytes in this thread's ring, blocking while it is full.
+uint8_t* reserve(size_t size);
+// Publishes the record written into the last reservation.
+void commit(size_t size);
+
+template <typename T>
+size_t arg_size(const T& value) {
+  using U = std::decay_t<T>;
+  if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+    return 1 + sizeof(uint32_t) + (value ? std::strlen(value) : 6);
+  } else {
+    return 1 + 8;
+  }
+}
+
+template <typename T>
+void put_arg(uint8_t*& out, size_t& budget, const T& value) {
+  using U = std::decay_t<T>;
+  auto put = [&](Tag tag, const void* data, size_t size) {
+    *out++ = static_cast<uint8_t>(tag);
+    std::memcpy(out, data, size);
+    out += size;
+  };
+  if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+    const char* text = value ? value : "(null)";
+    auto length = static_cast<uint32_t>(std::min(std::strlen(text), budget));
+    budget -= length;
+    *out++ = static_cast<uint8_t>(Tag::str);
+    std::memcpy(out, &length, sizeof(length));
+    out += sizeof(length);
+    std::memcpy(out, text, length);
+    out += length;
+  } else if constexpr (std::is_floating_point_v<U>) {
+    auto v = static_cast<double>(value);
+    put(Tag::f64, &v, 8);
+  } else if constexpr (std::is_pointer_v<U> || std::is_null_pointer_v<U>) {
+    auto v = reinterpret_cast<uintptr_t>(static_cast<const void*>(value));
+    uint64_t wide = v;
+    put(Tag::ptr, &wide, 8);
+  } else if constexpr (std::is_enum_v<U>) {
+    auto v = static_cast<int64_t>(value);
+    put(Tag::i64, &v, 8);
+  } else if constexpr (std::is_signed_v<U>) {
+    auto v = static_cast<int64_t>(value);
+    put(Tag::i64, &v, 8);
+  } else {
+    static_assert(std::is_unsigned_v<U>, "printf-style arguments only");
+    auto v = static_cast<uint64_t>(value);
+    put(Tag::u64, &v, 8);
+  }
+}
+
+}  // namespace detail
+
+// Starts the background writer; until then (and after stop()) the macros log synchronously.
+void start();
+// Writes out everything pending and stops the background writer.
+void stop();
+// Writes out everything recorded so far, on the calling thread.
+void flush();
+
+[[nodiscard]] inline bool enabled() { return detail::enabled.load(std::memory_order_relaxed); }
+
+template <typename... Args>
+void record(loguru::Verbosity verbosity, const char* file, unsigned line, const char* format,
+            const Args&... args) {
+  size_t size = sizeof(detail::Header);
+  ((size += detail::arg_size(args)), ...);
+  size = std::min(size, detail::kMaxRecord);
+  [[maybe_unused]] size_t strings =  // unused by calls without arguments
+      detail::kMaxRecord - sizeof(detail::Header) - 9 * sizeof...(Args);
+
+  uint8_t* start = detail::reserve(size);
+  uint8_t* out = start + sizeof(detail::Header);
+  (detail::put_arg(out, strings, args), ...);
+  detail::Header header{};
+  header.wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  header.format = format;
+  header.file = file;
+  header.line = line;
+  header.verbosity = verbosity;
+  header.size = static_cast<uint32_t>(out - start);
+  std::memcpy(start, &header, sizeof(header));
+  detail::commit(header.size);
+}
+
+}  // namespace mortido::logging
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+
+namespace mortido::perf {
+
+// One turn against the server's deadline, in milliseconds. NaN where the turn did not get that
+// far (no command sent, first turn has no sleep or period jitter).
+struct TurnTiming {
+  int turn = 0;
+  int ends_in_ms = 0;  // turnEndsInMs of the `/units` body
+  float units_ms = NAN;  // blocking `/units` request, rate limit sleeps included
+  float think_ms = NAN;  // `/units` received to `/command` sent
+  float command_ms = NAN;  // blocking `/command` request
+  float margin_ms = NAN;  // deadline minus command acknowledged, negative when late
+  float sleep_ms = NAN;  // waiting for the previous turn to end
+  float period_jitter_ms = NAN;  // deadline minus the previous one, minus the median period
+  float clock_offset_ms = NAN;  // server Date header minus local wall clock, +-500 ms
+};
+
+// Tracks how close every command gets to the turn deadline. The deadline is taken
+// conservatively as `/units` request start + turnEndsInMs: the body may have been produced
+// right after the request arrived. Period jitter is how far the interval between consecutive
+// local deadline estimates strays from the median turn length: mostly network and server
+// latency variation. Clock skew is the server wall clock minus ours (Api::*_clock_offset_ms):
+// once per game from /rounds, and per turn from the `/units` Date header. A Date sample is only
+// good to +-500 ms, but their mean over a game is close, as turns fall at any point of a second.
+//
+// Logs a warning when the moving average of the margin falls below `warn_margin_ms` (again
+// once it has recovered to twice that), and every command acknowledged after the deadline.
+class DeadlineMonitor {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit DeadlineMonitor(double warn_margin_ms = 200.0)
+      : warn_margin_ms_(warn_margin_ms)
+      , lower_periods_(std::less<float>(), reserved(kExpectedTurns / 2))
+      , upper_periods_(std::greater<float>(), reserved(kExpectedTurns / 2)) {
+    turns_.reserve(kExpectedTurns);
+  }
+
+  void units_requested() {
+    auto now = Clock::now();
+    if (waiting_) {
+      pending_sleep_ms_ = ms(now - wait_start_);
+      waiting_ = false;
+    }
+    units_start_ = now;
+  }
+
+  // After the body is decoded. A repeated turn (the server had not moved on yet) updates the
+  // last row instead of adding one.
+  // The /rounds clock offset before the game, if the Api measured one.
+  void set_round_clock_offset(std::optional<double> offset_ms) {
+    round_clock_offset_ms_ = offset_ms.value_or(NAN);
+  }
+
+  void units_received(int turn, int ends_in_ms,
+                      std::optional<double> clock_offset_ms = std::nullopt) {
+    auto now = Clock::now();
+    auto deadline = units_start_ + std::chrono::milliseconds(ends_in_ms);
+    if (turns_.empty() || turns_.back().turn != turn) {
+      auto& timing = turns_.emplace_back();
+      timing.turn = turn;
+      timing.sleep_ms = pending_sleep_ms_;
+      if (turns_.size() >= 2 && turns_[turns_.size() - 2].turn == turn - 1) {
+        float period = ms(deadline - deadline_);
+        add_period(period);
+        timing.period_jitter_ms = period - upper_periods_.top();
+      }
+    }
+    pending_sleep_ms_ = NAN;
+    auto& timing = turns_.back();
+    timing.ends_in_ms = ends_in_ms;
+    timing.units_ms = ms(now - units_start_);
+    timing.clock_offset_ms = static_cast<float>(clock_offset_ms.value_or(NAN));
+    deadline_ = deadline;
+    received_ = now;
+  }
+
+  void command_requested() { command_start_ = Clock::now(); }
+
+  void command_acknowledged() {
+    if (turns_.empty()) {
+      return;
+    }
+    auto now = Clock::now();
+    auto& timing = turns_.back();
+    timing.think_ms = ms(command_start_ - received_);
+    timing.command_ms = ms(now - command_start_);
+    timing.margin_ms = ms(deadline_ - now);
+    check(timing);
+  }
+
+  void waiting() {
+    wait_start_ = Clock::now();
+    waiting_ = true;
+  }
+
+  [[nodiscard]] const std::vector<TurnTiming>& turns() const { return turns_; }
+
+  // Time series as "turn ends_in_ms units_ms think_ms command_ms margin_ms sleep_ms
+  // period_jitter_ms clock_offset_ms", one turn per line, "-" for missing values, after summary
+  // comments.
+  bool write(const std::filesystem::path& path, const std::string& title) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+      return false;
+    }
+    std::vector<float> margins;
+    double offset_sum = 0.0;
+    size_t offsets = 0;
+    for (const auto& timing : turns_) {
+      if (!std::isnan(timing.margin_ms)) {
+        margins.push_back(timing.margin_ms);
+      }
+      if (!std::isnan(timing.clock_offset_ms)) {
+        offset_sum += timing.clock_offset_ms;
+        offsets++;
+      }
+    }
+    std::sort(margins.begin(), margins.end());
+    auto late = std::lower_bound(margins.begin(), margins.end(), 0.0f) - margins.begin();
+    std::fprintf(file, "# %s\n", title.c_str());
+    if (!margins.empty()) {
+      std::fprintf(file, "# %zu commands, %td late, margin min %.1f p10 %.1f p50 %.1f ms\n",
+                   margins.size(), late, margins.front(), margins[margins.size() / 10],
+                   margins[margins.size() / 2]);
+    }
+    if (!std::isnan(round_clock_offset_ms_) || offsets > 0) {
+      std::fprintf(file,
+                   "# server clock offset: /rounds %+.1f ms, Date mean %+.1f ms over %zu turns\n",
+                   round_clock_offset_ms_, offsets > 0 ? offset_sum / offsets : NAN, offsets);
+    }
+    std::fputs(
+        "turn ends_in_ms units_ms think_ms command_ms margin_ms sleep_ms period_jitter_ms "
+        "clock_offset_ms\n",
+        file);
+    for (const auto& t : turns_) {
+      std::fprintf(file, "%d %d", t.turn, t.ends_in_ms);
+      for (float value : {t.units_ms, t.think_ms, t.command_ms, t.margin_ms, t.sleep_ms,
+                          t.period_jitter_ms, t.clock_offset_ms}) {
+        if (std::isnan(value)) {
+          std::fputs(" -", file);
+        } else {
+          std::fprintf(file, " %.1f", value);
+        }
+      }
+      std::fputc('\n', file);
+    }
+    std::fclose(file);
+    return true;
+  }
+
+ private:
+  constexpr static double kTrendAlpha = 0.2;
+  constexpr static size_t kExpectedTurns = 2048;  // reserved up front, longer games still fit
+
+  double warn_margin_ms_;
+  double margin_trend_ms_ = std::numeric_limits<double>::quiet_NaN();
+  double round_clock_offset_ms_ = std::numeric_limits<double>::quiet_NaN();
+  bool warned_ = false;
+
+  std::vector<TurnTiming> turns_;
+  // Running median of the turn periods: the lower half in a max-heap, the upper half (the
+  // median on top) in a min-heap, so a turn costs O(log n) and no copy.
+  std::priority_queue<float, std::vector<float>, std::less<float>> lower_periods_;
+  std::priority_queue<float, std::vector<float>, std::greater<float>> upper_periods_;
+  Clock::time_point units_start_;
+  Clock::time_point received_;
+  Clock::time_point command_start_;
+  Clock::time_point wait_start_;
+  Clock::time_point deadline_;
+  bool waiting_ = false;
+  float pending_sleep_ms_ = NAN;
+
+  static float ms(Clock::duration duration) {
+    return std::chrono::duration<float, std::milli>(duration).count();
+  }
+
+  static std::vector<float> reserved(size_t capacity) {
+    std::vector<float> values;
+    values.reserve(capacity);
+    return values;
+  }
+
+  // Keeps upper_periods_ one larger than lower_periods_ or equal, so its top is the element at
+  // index n / 2 of the sorted periods.
+  void add_period(float period) {
+    if (!upper_periods_.empty() && period < upper_periods_.top()) {
+      lower_periods_.push(period);
+    } else {
+      upper_periods_.push(period);
+    }
+    if (lower_periods_.size() > upper_periods_.size()) {
+      upper_periods_.push(lower_periods_.top());
+      lower_periods_.pop();
+    } else if (upper_periods_.size() > lower_periods_.size() + 1) {
+      lower_periods_.push(upper_periods_.top());
+      upper_periods_.pop();
+    }
+  }
+
+  void check(const TurnTiming& timing) {
+    if (timing.margin_ms < 0) {
+      LOG_WARN("Turn %d command acknowledged %.0f ms after the deadline", timing.turn,
+               -timing.margin_ms);
+    }
+    margin_trend_ms_ = std::isnan(margin_trend_ms_)
+                           ? timing.margin_ms
+                           : margin_trend_ms_ + kTrendAlpha * (timing.margin_ms - margin_trend_ms_);
+    if (!warned_ && margin_trend_ms_ < warn_margin_ms_) {
+      LOG_WARN("Turn %d deadline margin trending down: %.0f ms on average, %.0f ms this turn",
+               timing.turn, margin_trend_ms_, timing.margin_ms);
+      warned_ = true;
+    } else if (warned_ && margin_trend_ms_ > 2 * warn_margin_ms_) {
+      LOG_INFO("Turn %d deadline margin recovered: %.0f ms on average", timing.turn,
+               margin_trend_ms_);
+      warned_ = false;
+    }
+  }
+};
+
+}  // namespace mortido::perf
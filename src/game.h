@@ -1,14 +1,22 @@
 #pragma once
 
+#include <rapidjson/error/en.h>
 #include <rapidjson/writer.h>
 
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
 
 #include "api/api.h"
+#include "api/frame_file.h"
+#include "deadline.h"
 #include "logger.h"
 #include "models/state.h"
+#include "models/units_reader.h"
+#include "perf.h"
+#include "trace.h"
 
 using namespace std::chrono_literals;
 
@@ -16,7 +24,22 @@ namespace mortido::game {
 
 class Game {
  public:
-  explicit Game(std::string game_id, api::Api& api) : id_{std::move(game_id)}, api_(api) {}
+  explicit Game(std::string game_id, api::Api& api, const models::Params& params = {})
+      : id_{std::move(game_id)}, api_(api) {
+    api_.set_json_arena(&json_arena_);
+    state_.set_params(params);
+  }
+
+  ~Game() { api_.set_json_arena(nullptr); }
+
+  // Phase timings of the turns played so far.
+  [[nodiscard]] const perf::Profile& profile() const { return profile_; }
+  // Per turn margins against the server deadline.
+  [[nodiscard]] const perf::DeadlineMonitor& deadlines() const { return deadlines_; }
+
+  // DRAW builds: record the viewer frames to `path` (api/frame_file.h) instead of drawing to a
+  // live viewer, which stays the default when no path is set.
+  void set_frames_file(std::filesystem::path path) { frames_file_ = std::move(path); }
 
   bool run() {
     auto participate_result = api_.participate();
@@ -47,17 +70,24 @@ class Game {
  private:
   std::string id_;
   api::Api& api_;
+  api::JsonArena json_arena_;
 
   std::string team_name_;
   models::State state_;
+  models::UnitsReader units_reader_;
+  models::UnitsSnapshot units_;
+  perf::Profile profile_;
+  perf::DeadlineMonitor deadlines_;
+  std::filesystem::path frames_file_;
 
   bool load_world() {
-    rapidjson::Document world;
-    std::optional<api::Error> maybe_error;
-    do {
+    TRACE_SCOPE("load_world");
+    auto world = api_.get_world();
+    auto maybe_error = api::Error::from_json(world);
+    while (maybe_error && maybe_error->message.find("lobby ends in") != std::string::npos) {
       world = api_.get_world();
       maybe_error = api::Error::from_json(world);
-    } while (maybe_error && maybe_error->message.find("lobby ends in") != std::string::npos);
+    }
 
     if (maybe_error) {
       LOG_ERROR("Get world error [%d]: %s", maybe_error->err_code, maybe_error->message.c_str());
@@ -69,54 +99,102 @@ class Game {
   }
 
   bool load_units() {
-    rapidjson::Document units;
+    PERF_SCOPE(load_units);
     std::optional<api::Error> maybe_error;
-    do {
-      units = api_.get_units();
-      maybe_error = api::Error::from_json(units);
-    } while (maybe_error && maybe_error->message.find("lobby ends in") != std::string::npos);
+    size_t attempts = 0;  // shared with the request's own retries
+    while (true) {
+      deadlines_.units_requested();
+      auto json = api_.get_units_json_within(attempts);
+      bool parsed;
+      {
+        PERF_SCOPE(parse);
+        parsed = units_reader_.read(json, units_);
+      }
+      if (!parsed) {
+        LOG_ERROR("Units JSON parse error: %s, offset: %zu",
+                  rapidjson::GetParseError_En(units_reader_.error_code()),
+                  units_reader_.error_offset());
+        // Re-requested within the same budget as transport errors, as HttpApi retries bodies
+        // that don't parse.
+        if (attempts >= api_.max_retries()) {
+          LOG_ERROR("Units were not parsed");
+          return false;
+        }
+        continue;
+      }
+      maybe_error = units_.error();
+      if (!maybe_error || maybe_error->message.find("lobby ends in") == std::string::npos) {
+        break;
+      }
+      attempts = 0;  // waiting in the lobby is not a failure
+    }
 
     if (maybe_error) {
       LOG_ERROR("Get state error [%d]: %s", maybe_error->err_code, maybe_error->message.c_str());
       return false;
     }
 
-    state_.update_from_json(units);
+    PERF_SCOPE(update_state);
+    state_.update_from_units(units_);
+    deadlines_.units_received(state_.turn, units_.turn_ends_in_ms, api_.date_clock_offset_ms());
     return true;
   }
 
   void game_loop() {
 #ifdef DRAW
-    rewind_viewer::RewindClient rc("127.0.0.1", 9111);
+    api::FrameWriter frames;  // outlives rc, whose sender thread writes to it
+    std::unique_ptr<rewind_viewer::RewindClient> rc;
+    if (!frames_file_.empty() &&
+        frames.open(frames_file_, rewind_viewer::MESSAGE_SCHEMA_VERSION)) {
+      rc = std::make_unique<rewind_viewer::RewindClient>(
+          [&frames](const uint8_t* data, size_t size) { frames.write(data, size); });
+    } else {
+      rc = std::make_unique<rewind_viewer::RewindClient>("127.0.0.1", 9111);
+    }
 #endif
 
+    perf::BindProfile bind_profile(profile_);
     LOG_INFO("Game %s started, team: %s", id_.c_str(), team_name_.c_str());
+    deadlines_.set_round_clock_offset(api_.round_clock_offset_ms());
     load_world();
     while (!state_.game_ended_at && state_.turn < 449) {  // TODO: ended by surviving...
-      if (!load_units()) {
-        return;
-      }
+      {
+        PERF_SCOPE(turn);
+        json_arena_.next_turn();
+        if (!load_units()) {
+          return;
+        }
 
-      if (state_.game_ended_at) {
-        LOG_INFO("GAME %s ENDED AT %s, status: %s", id_.c_str(), state_.game_ended_at->c_str(),
-                 state_.end_status.c_str());
-      } else {
-        if (state_.map.view_zone_updated) {
-          load_world();
+        if (state_.game_ended_at) {
+          LOG_INFO("GAME %s ENDED AT %s, status: %s", id_.c_str(),
+                   state_.game_ended_at->c_str(), state_.end_status.c_str());
+        } else {
+          if (state_.map.view_zone_updated) {
+            load_world();
+          }
+          auto command = state_.get_action();
+          PERF_SCOPE(send_command);
+          deadlines_.command_requested();
+          auto result = api_.send_command(command);
+          deadlines_.command_acknowledged();
+          //      auto maybe_error = api::Error::from_json(result);
+          //      if (maybe_error) {
+          //        LOG_ERROR("Send command error [%d]: %s", maybe_error->err_code,
+          //        maybe_error->message.c_str());
+          //      }
         }
-        auto result = api_.send_command(state_.get_action());
-        //      auto maybe_error = api::Error::from_json(result);
-        //      if (maybe_error) {
-        //        LOG_ERROR("Send command error [%d]: %s", maybe_error->err_code,
-        //        maybe_error->message.c_str());
-        //      }
       }
 
 #ifdef DRAW
-      state_.draw(rc);
+      {
+        PERF_SCOPE(draw);
+        state_.draw(*rc);
+      }
 #endif
 
       LOG_INFO("Wait turn %d to end...", state_.turn);
+      TRACE_SCOPE("wait_turn_end");
+      deadlines_.waiting();
       std::this_thread::sleep_until(state_.turn_end_time);
     }
   }
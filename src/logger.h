@@ -2,8 +2,19 @@
 
 #include <loguru.hpp>
 
-#define LOG_INFO(format, ...)   LOG_F(INFO,      format, ##__VA_ARGS__)
-#define LOG_WARN(format, ...)   LOG_F(WARNING,   format, ##__VA_ARGS__)
-#define LOG_ERROR(format, ...)  LOG_F(ERROR,     format, ##__VA_ARGS__)
-#define LOG_FATAL(format, ...)  LOG_F(FATAL,     format, ##__VA_ARGS__)
-#define LOG_DEBUG(format, ...)  LOG_F(1,         format, ##__VA_ARGS__)
+#include "async_log.h"
+
+// Synchronous loguru calls until mortido::logging::start(), records for the background writer
+// after it (async_log.h). FATAL is always synchronous, after everything pending is written.
+#define MORTIDO_LOG(verbosity, format, ...)                                                    \
+  ((verbosity) > loguru::current_verbosity_cutoff()                                            \
+       ? (void)0                                                                               \
+       : mortido::logging::enabled()                                                           \
+             ? mortido::logging::record(verbosity, __FILE__, __LINE__, format, ##__VA_ARGS__) \
+             : loguru::log(verbosity, __FILE__, __LINE__, format, ##__VA_ARGS__))
+
+#define LOG_INFO(format, ...)   MORTIDO_LOG(loguru::Verbosity_INFO,    format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...)   MORTIDO_LOG(loguru::Verbosity_WARNING, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...)  MORTIDO_LOG(loguru::Verbosity_ERROR,   format, ##__VA_ARGS__)
+#define LOG_FATAL(format, ...)  (mortido::logging::flush(), LOG_F(FATAL, format, ##__VA_ARGS__))
+#define LOG_DEBUG(format, ...)  MORTIDO_LOG(loguru::Verbosity_1,       format, ##__VA_ARGS__)
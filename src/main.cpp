@@ -1,7 +1,9 @@
 #include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <string_view>
 #include <thread>
 
 #include "api/dump_v2.h"
@@ -9,12 +11,26 @@
 #include "game.h"
 #include "logger.h"
 
+#ifdef ALLOC_TRACKING
+#include "alloc_hooks.h"
+#endif
+
 using namespace std::chrono_literals;
 
 constexpr const size_t kMaxRPS = 3;
 
 constexpr const char *kServerURL = "https://games-test.datsteam.dev";
 // constexpr const char *kServerURL = "https://games.datsteam.dev";
+// Overrides kServerURL, e.g. to run against mortido-mock-server on loopback.
+constexpr const char *kServerURLEnv = "MORTIDO_SERVER_URL";
+// Set to 1 to also write data/<round>.rpl (replay_file.h) during the game; mortido-dump-convert
+// produces it from the .dump offline.
+constexpr const char *kReplayEnv = "MORTIDO_WRITE_RPL";
+// Set to 1 to also write data/<round>.dlt (delta_file.h), which the replay tools read directly.
+constexpr const char *kDeltaEnv = "MORTIDO_WRITE_DLT";
+// DRAW builds: set to 1 to record the viewer frames to data/<round>.frames (mortido-frame-player
+// streams them later) instead of drawing to a live viewer.
+constexpr const char *kFramesEnv = "MORTIDO_RECORD_FRAMES";
 
 const std::filesystem::path kDataDir = "data";
 constexpr const char *kTokenFile = "token.txt";
@@ -40,6 +56,11 @@ std::string read_token() {
   return token;
 }
 
+bool env_flag(const char *name) {
+  const char *value = std::getenv(name);
+  return value != nullptr && std::string_view(value) == "1";
+}
+
 std::string format_time_point_as_local_time(const std::chrono::system_clock::time_point &tp) {
   std::time_t time = std::chrono::system_clock::to_time_t(tp);
   std::tm local_tm = *std::localtime(&time);
@@ -50,15 +71,23 @@ std::string format_time_point_as_local_time(const std::chrono::system_clock::tim
 
 int main(int argc, char *argv[]) {
   loguru::init(argc, argv);
-  loguru::g_flush_interval_ms = 0;  // unbuffered
+  loguru::g_flush_interval_ms = 0;  // unbuffered, written from the async log thread
   loguru::add_file((kDataDir / kMainLogFile).c_str(), loguru::Append, loguru::Verbosity_WARNING);
+  mortido::logging::start();
 
-    mortido::api::HttpApi api(kServerURL, read_token(), kMaxRPS, 30);
+  const char *server_url = std::getenv(kServerURLEnv);
+  if (server_url == nullptr || *server_url == '\0') {
+    server_url = kServerURL;
+  }
+  LOG_INFO("Server: %s", server_url);
+  mortido::api::HttpApi api(server_url, read_token(), kMaxRPS, 30);
 //  mortido::api::DumpApi api(kDataDir / kReplayFile);
   std::string prev_round_name;
 
   while (api.active()) {
     api.set_dump_file(kDataDir / kMainDumpFile);
+    api.set_replay_file({});
+    api.set_delta_file({});
     auto round = api.get_current_round(prev_round_name);
     LOG_INFO("ROUND %s DURATION: %.1f min", round.name.c_str(),
              static_cast<double>(round.duration) / 60.0);
@@ -77,18 +106,49 @@ int main(int argc, char *argv[]) {
 
     LOG_INFO("Game %s has started.", round.name.c_str());
     api.set_dump_file((kDataDir / round.name).replace_extension(".dump"));
+    if (env_flag(kReplayEnv)) {
+      api.set_replay_file((kDataDir / round.name).replace_extension(".rpl"));
+    }
+    if (env_flag(kDeltaEnv)) {
+      api.set_delta_file((kDataDir / round.name).replace_extension(".dlt"));
+    }
     const auto game_log_file = (kDataDir / round.name).replace_extension(".log");
+    mortido::logging::flush();  // earlier records stay out of the game log
     loguru::add_file(game_log_file.c_str(), loguru::Append, loguru::Verbosity_MAX);
     mortido::game::Game game(round.name, api);
+#ifdef DRAW
+    if (env_flag(kFramesEnv)) {
+      game.set_frames_file((kDataDir / round.name).replace_extension(".frames"));
+    }
+#endif
+#ifdef TRACE
+    mortido::trace::Tracer::instance().clear();
+#endif
     while (!game.run()) {
       LOG_ERROR("GAME %s FINISHED WITH NEGATIVE RESULT, RELOADING...", round.name.c_str());
     }
     LOG_INFO("GAME %s FINISHED", round.name.c_str());
+    const auto perf_file = (kDataDir / round.name).replace_extension(".perf");
+    if (!game.profile().write(perf_file, round.name)) {
+      LOG_ERROR("Could not write %s", perf_file.c_str());
+    }
+    const auto deadline_file = (kDataDir / round.name).replace_extension(".deadline");
+    if (!game.deadlines().write(deadline_file, round.name)) {
+      LOG_ERROR("Could not write %s", deadline_file.c_str());
+    }
+#ifdef TRACE
+    const auto trace_file = (kDataDir / round.name).replace_extension(".trace.json");
+    if (!mortido::trace::Tracer::instance().write(trace_file)) {
+      LOG_ERROR("Could not write %s", trace_file.c_str());
+    }
+#endif
+    mortido::logging::flush();
     loguru::remove_callback(game_log_file.c_str());
     loguru::flush();
     prev_round_name = round.name;
   }
 
+  mortido::logging::stop();
   loguru::remove_all_callbacks();
   loguru::flush();
 
@@ -7,14 +7,12 @@
 #include <vector>
 
 #include "models/building.h"
+#include "models/params.h"
 #include "models/vec2i.h"
 #include "models/zombie.h"
 
 namespace mortido::models {
 
-constexpr static size_t kLookAhead = 15;
-constexpr static double kTimeFactor = 0.9;
-
 struct Cell {
   enum class Type {
     normal,
@@ -98,6 +96,7 @@ class Map {
   std::vector<vec2i> straight_directions_;
   std::vector<vec2i> diagonal_directions_;
   std::unordered_map<int, std::vector<vec2i>> attack_cache_;
+  Params params_;
   double const_time_factor;
   std::unordered_map<Zombie::Type, Zombie> proto_zombie;
 
@@ -142,10 +141,16 @@ class Map {
     diagonal_directions_.emplace_back(1, 1);
     diagonal_directions_.emplace_back(1, -1);
 
+    set_params(params_);
+  }
+
+  void set_params(const Params& params) {
+    params_ = params;
+    const_time_factor = 0.0;
     double t = 1.0;
-    for (size_t i = 0; i < kLookAhead; i++) {
+    for (size_t i = 0; i < params_.look_ahead; i++) {
       const_time_factor += t;
-      t *= kTimeFactor;
+      t *= params_.time_factor;
     }
   }
 
@@ -304,7 +309,7 @@ class Map {
         proto_zombie[zombie.type].update_proto(zombie);
       }
 
-      auto future_positions = zombie.get_future_positions(kLookAhead, kTimeFactor,
+      auto future_positions = zombie.get_future_positions(params_.look_ahead, params_.time_factor,
                                                           proto_zombie[zombie.type].wait_turns);
 
       for (size_t fp = 0; fp < future_positions.size(); fp++) {
@@ -442,12 +447,12 @@ class Map {
       }
 
       cell.spawn_danger += current->damage;
-      if (current->step < static_cast<int>(kLookAhead)) {
-        if (cell.building) {
-          current->damage *=
-              std::pow(kTimeFactor, 1.0 + std::ceil(buildings[cell.building].health / mean_dmg));
+      if (current->step < static_cast<int>(params_.look_ahead)) {
+        if (cell.building >= 0) {
+          current->damage *= std::pow(params_.time_factor,
+                                      1.0 + std::ceil(buildings[cell.building].health / mean_dmg));
         } else {
-          current->damage *= kTimeFactor;
+          current->damage *= params_.time_factor;
         }
 
         current->step++;
@@ -526,7 +531,7 @@ class Map {
       if (building.health > cell.damage_taken) {
         int strikes = (building.health + power - 1) / power;
         if (building.is_head) {
-          score += static_cast<double>(strikes) * building.danger * 100.0;
+          score += static_cast<double>(strikes) * building.danger * params_.head_attack_weight;
         } else {
           score += static_cast<double>(strikes) * building.danger;
         }
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace mortido::models {
+
+// Strategy weights that used to be hard-coded in Map and State. Defaults are the tuned values;
+// the sweep tool overrides them by name.
+struct Params {
+  // Map: how far and how steeply zombie, spawn and enemy danger are projected into the future.
+  size_t look_ahead = 15;
+  double time_factor = 0.9;
+  // Map::get_attack_score: an enemy head is worth this many ordinary blocks.
+  double head_attack_weight = 100.0;
+
+  // State::build, lower score builds first.
+  double build_base_distance_weight = 0.25;
+  double build_spawn_distance_weight = 0.2;
+  double build_enemy_distance_weight = 0.2;
+  // From this turn on the base grows towards enemies instead of away from them.
+  int build_late_turn = 240;
+  double build_late_enemy_distance_weight = 0.2;
+  // From this turn on the lattice holes away from the head are left unbuilt.
+  int build_lattice_turn = 140;
+
+  // State::move_base, lower score wins.
+  double move_danger_weight = 100.0;
+  double move_distance_weight = 1.0;
+  double move_attack_weight = 0.0001;
+
+  // Calls fn(name, field) for every parameter, `field` is a reference of the field's type.
+  template <typename P, typename F>
+  static void for_each(P& params, F&& fn) {
+    fn("look_ahead", params.look_ahead);
+    fn("time_factor", params.time_factor);
+    fn("head_attack_weight", params.head_attack_weight);
+    fn("build_base_distance_weight", params.build_base_distance_weight);
+    fn("build_spawn_distance_weight", params.build_spawn_distance_weight);
+    fn("build_enemy_distance_weight", params.build_enemy_distance_weight);
+    fn("build_late_turn", params.build_late_turn);
+    fn("build_late_enemy_distance_weight", params.build_late_enemy_distance_weight);
+    fn("build_lattice_turn", params.build_lattice_turn);
+    fn("move_danger_weight", params.move_danger_weight);
+    fn("move_distance_weight", params.move_distance_weight);
+    fn("move_attack_weight", params.move_attack_weight);
+  }
+
+  // Returns false if there is no parameter called `name`.
+  bool set(std::string_view name, double value) {
+    bool found = false;
+    for_each(*this, [&](std::string_view field_name, auto& field) {
+      if (field_name == name) {
+        field = static_cast<std::decay_t<decltype(field)>>(value);
+        found = true;
+      }
+    });
+    return found;
+  }
+
+  // "name=value ..." for the parameters that differ from `base`.
+  [[nodiscard]] std::string diff(const Params& base) const {
+    std::vector<double> base_values;
+    for_each(base, [&](std::string_view, const auto& field) {
+      base_values.push_back(static_cast<double>(field));
+    });
+    std::string out;
+    size_t index = 0;
+    for_each(*this, [&](std::string_view name, const auto& field) {
+      if (static_cast<double>(field) != base_values[index++]) {
+        if (!out.empty()) out += ' ';
+        out.append(name).append("=").append(format(field));
+      }
+    });
+    return out.empty() ? "defaults" : out;
+  }
+
+ private:
+  template <typename T>
+  static std::string format(T value) {
+    if constexpr (std::is_floating_point_v<T>) {
+      auto text = std::to_string(value);
+      text.erase(text.find_last_not_of('0') + 1);
+      if (text.back() == '.') text.pop_back();
+      return text;
+    } else {
+      return std::to_string(value);
+    }
+  }
+};
+
+}  // namespace mortido::models
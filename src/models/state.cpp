@@ -2,7 +2,7 @@
 
 namespace mortido::models {
 
-bool State::update_from_json(const rapidjson::Document& doc) {
+bool State::update_from_json(const rapidjson::Value& doc) {
   int next_turn = doc["turn"].GetInt();
   if (turn == next_turn) {
     return false;
@@ -52,11 +52,61 @@ bool State::update_from_json(const rapidjson::Document& doc) {
     }
   }
 
-  map.update(turn);
+  {
+    PERF_SCOPE(map_update);
+    map.update(turn);
+  }
+  return true;
+}
+
+bool State::update_from_units(UnitsSnapshot& units) {
+  if (!units.turn) {
+    LOG_ERROR("Units without turn");
+    return false;
+  }
+  int next_turn = *units.turn;
+  if (turn == next_turn) {
+    return false;
+  }
+
+  if(next_turn - turn > 1) {
+    LOG_ERROR("TURN SKIPPED %d -> %d", turn, next_turn);
+  }
+
+  turn_end_time =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(units.turn_ends_in_ms);
+  turn = next_turn;
+  me.name = units.player.name;
+  me.gold = units.player.gold;
+  me.enemy_block_kills = units.player.enemy_block_kills;
+  me.points = units.player.points;
+  me.zombie_kills = units.player.zombie_kills;
+  if (units.game_ended_at) {
+    game_ended_at = units.game_ended_at;
+    end_status = "GAME OVER";
+  } else {
+    game_ended_at.reset();
+  }
+
+  map.clear();
+  for (auto& b : units.base) {
+    map.add_building(std::move(b));
+  }
+  for (auto& b : units.enemy_blocks) {
+    map.add_building(std::move(b));
+  }
+  for (auto& zombie : units.zombies) {
+    map.add_zombie(std::move(zombie));
+  }
+
+  {
+    PERF_SCOPE(map_update);
+    map.update(turn);
+  }
   return true;
 }
 
-void State::init_from_json(const rapidjson::Document& doc) {
+void State::init_from_json(const rapidjson::Value& doc) {
   if (doc.HasMember("zpots") && doc["zpots"].IsArray()) {
     map.clear_spawns_and_walls();
     for (const auto& zp : doc["zpots"].GetArray()) {
@@ -2,6 +2,8 @@
 
 #include <rapidjson/document.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <optional>
 #include <vector>
@@ -9,10 +11,13 @@
 #include "api/requests.h"
 #include "logger.h"
 #include "models/map.h"
+#include "models/params.h"
 #include "models/player.h"
+#include "models/units_reader.h"
 #include "models/vec2d.h"
 #include "models/vec2i.h"
 #include "models/zombie.h"
+#include "perf.h"
 
 #ifdef DRAW
 #include <rewind_viewer/RewindClient.h>
@@ -27,6 +32,7 @@ struct State {
   int turn = -1;
   Player me;
   Map map;
+  Params params;
   std::chrono::steady_clock::time_point turn_end_time;
   std::optional<std::string> game_ended_at;
   std::string end_status;
@@ -35,16 +41,34 @@ struct State {
   std::optional<vec2i> move_base_command;
   std::vector<api::AttackCommand> attack_command;
 
-  bool update_from_json(const rapidjson::Document& doc);
+  void set_params(const Params& p) {
+    params = p;
+    map.set_params(p);
+  }
+
+  bool update_from_json(const rapidjson::Value& doc);
 
-  void init_from_json(const rapidjson::Document& doc);
+  // Same as update_from_json, but takes a snapshot decoded by UnitsReader. Entities are moved
+  // out of `units`.
+  bool update_from_units(UnitsSnapshot& units);
+
+  void init_from_json(const rapidjson::Value& doc);
 
   api::Command get_action() {
-    return api::Command{
-        .attack = attack(),
-        .build = build(),
-        .move_base = move_base(),
-    };
+    api::Command command;
+    {
+      PERF_SCOPE(attack);
+      command.attack = attack();
+    }
+    {
+      PERF_SCOPE(build);
+      command.build = build();
+    }
+    {
+      PERF_SCOPE(move_base);
+      command.move_base = move_base();
+    }
+    return command;
   }
 
   const std::vector<api::AttackCommand>& attack() {
@@ -109,14 +133,14 @@ struct State {
         }
       }
 
-      double score = danger_score + 0.25 * distance_to_centroid;
+      double score = danger_score + params.build_base_distance_weight * distance_to_centroid;
 
-      if (turn < 240) {
-        score += 0.2 * min_distance_to_spawn;
-        score += 0.2 * min_distance_to_enemy;
+      if (turn < params.build_late_turn) {
+        score += params.build_spawn_distance_weight * min_distance_to_spawn;
+        score += params.build_enemy_distance_weight * min_distance_to_enemy;
       } else {
         //        min_distance_to_spawn = 0;
-        score -= 0.2 * min_distance_to_enemy;
+        score -= params.build_late_enemy_distance_weight * min_distance_to_enemy;
       }
 
       if (nearest_cluster_size > 0) {
@@ -131,7 +155,7 @@ struct State {
 
     for (const auto& candidate : candidate_scores) {
       if (candidate.position.x % 5 == shift_pattern[candidate.position.y % shift_pattern.size()] &&
-          turn > 140) {
+          turn > params.build_lattice_turn) {
         if ((map.buildings[map.my_base].position - candidate.position).sq_length() > 4) {
           continue;
         }
@@ -231,7 +255,9 @@ struct State {
       //      return 10.0 * danger + dist_to_centroid - std::sqrt(min_distance_to_spawn);
       //      return 100.0 * danger - neighbours_score;
       //      return 100.0 * danger + dist_to_centroid;
-      return 100.0 * danger + (pos - prev_pos).length() + attack_score * 0.0001;
+      return params.move_danger_weight * danger +
+             params.move_distance_weight * (pos - prev_pos).length() +
+             params.move_attack_weight * attack_score;
     };
 
     double best_score = std::numeric_limits<double>::max();
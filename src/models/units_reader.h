@@ -0,0 +1,440 @@
+#pragma once
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
+#include <array>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "api/responses.h"
+#include "models/building.h"
+#include "models/player.h"
+#include "models/zombie.h"
+
+namespace mortido::models {
+
+// Decoded `/units` payload. Filled by UnitsReader straight from SAX events, applied to the
+// map by State::update_from_units. Vectors keep their capacity between turns.
+struct UnitsSnapshot {
+  std::optional<int> turn;
+  int turn_ends_in_ms = 0;
+  Player player;
+  std::optional<std::string> game_ended_at;
+  std::vector<Building> base;
+  std::vector<Building> enemy_blocks;
+  std::vector<Zombie> zombies;
+
+  std::optional<int> err_code;
+  std::optional<std::string> err_message;
+
+  void clear() {
+    turn.reset();
+    turn_ends_in_ms = 0;
+    player = Player{};
+    game_ended_at.reset();
+    base.clear();
+    enemy_blocks.clear();
+    zombies.clear();
+    err_code.reset();
+    err_message.reset();
+  }
+
+  // Same contract as api::Error::from_json: both errCode and error have to be present.
+  [[nodiscard]] std::optional<api::Error> error() const {
+    if (!err_code || !err_message) {
+      return std::nullopt;
+    }
+    return api::Error{.err_code = *err_code, .message = *err_message};
+  }
+};
+
+// Streaming decoder for the `/units` schema. Field names are interned to an enum and dispatched
+// with a switch, unknown fields (and their nested values) are skipped.
+class UnitsReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, UnitsReader> {
+ public:
+  // Returns false on malformed JSON, `out` is left partially filled in that case.
+  bool read(std::string_view json, UnitsSnapshot& out) {
+    out.clear();
+    out_ = &out;
+    depth_ = 0;
+    skip_depth_ = 0;
+    field_ = Field::unknown;
+    rapidjson::MemoryStream stream(json.data(), json.size());
+    auto result = reader_.Parse(stream, *this);
+    out_ = nullptr;
+    if (!result) {
+      error_code_ = result.Code();
+      error_offset_ = result.Offset();
+      return false;
+    }
+    return true;
+  }
+
+  [[nodiscard]] rapidjson::ParseErrorCode error_code() const { return error_code_; }
+  [[nodiscard]] size_t error_offset() const { return error_offset_; }
+
+  // SAX handler interface
+  bool Null() { return true; }
+  bool Bool(bool value) {
+    if (skip_depth_ == 0 && scope() == Scope::building && field_ == Field::is_head) {
+      building_->is_head = value;
+      has_is_head_ = true;
+    }
+    return true;
+  }
+  bool Int(int value) {
+    on_int(value);
+    return true;
+  }
+  bool Uint(unsigned value) {
+    on_int(static_cast<int>(value));
+    return true;
+  }
+  bool Int64(int64_t value) {
+    on_int(static_cast<int>(value));
+    return true;
+  }
+  bool Uint64(uint64_t value) {
+    on_int(static_cast<int>(value));
+    return true;
+  }
+  bool Double(double) { return true; }
+  bool String(const char* str, rapidjson::SizeType length, bool) {
+    if (skip_depth_ == 0) {
+      on_string(std::string_view(str, length));
+    }
+    return true;
+  }
+  bool Key(const char* str, rapidjson::SizeType length, bool) {
+    if (skip_depth_ == 0) {
+      field_ = intern_field(std::string_view(str, length));
+    }
+    return true;
+  }
+  bool StartObject() {
+    if (skip_depth_ > 0) {
+      ++skip_depth_;
+      return true;
+    }
+    switch (scope()) {
+      case Scope::none: push(Scope::root); break;
+      case Scope::root:
+        if (field_ == Field::player) {
+          push(Scope::player);
+        } else {
+          skip_depth_ = 1;
+        }
+        break;
+      case Scope::base_list:
+        start_building(out_->base.emplace_back(), false);
+        push(Scope::building);
+        break;
+      case Scope::enemy_list:
+        start_building(out_->enemy_blocks.emplace_back(), true);
+        push(Scope::building);
+        break;
+      case Scope::zombie_list:
+        zombie_ = &out_->zombies.emplace_back();
+        push(Scope::zombie);
+        break;
+      case Scope::building:
+        if (field_ == Field::last_attack) {
+          building_->last_attack.emplace();
+          push(Scope::last_attack);
+        } else {
+          skip_depth_ = 1;
+        }
+        break;
+      default: skip_depth_ = 1; break;
+    }
+    return true;
+  }
+  bool EndObject(rapidjson::SizeType) {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+      return true;
+    }
+    if (scope() == Scope::building) {
+      finish_building();
+    } else if (scope() == Scope::zombie && zombie_->type == Zombie::Type::chaos_knight) {
+      zombie_->speed = 1;  // todo: just in case...
+    }
+    --depth_;
+    return true;
+  }
+  bool StartArray() {
+    if (skip_depth_ > 0) {
+      ++skip_depth_;
+      return true;
+    }
+    if (scope() == Scope::root && field_ == Field::base) {
+      push(Scope::base_list);
+    } else if (scope() == Scope::root && field_ == Field::enemy_blocks) {
+      push(Scope::enemy_list);
+    } else if (scope() == Scope::root && field_ == Field::zombies) {
+      push(Scope::zombie_list);
+    } else {
+      skip_depth_ = 1;
+    }
+    return true;
+  }
+  bool EndArray(rapidjson::SizeType) {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+    } else {
+      --depth_;
+    }
+    return true;
+  }
+
+ private:
+  enum class Scope {
+    none,
+    root,
+    player,
+    base_list,
+    enemy_list,
+    zombie_list,
+    building,
+    last_attack,
+    zombie,
+  };
+
+  enum class Field {
+    unknown,
+    x,
+    y,
+    id,
+    base,
+    turn,
+    gold,
+    name,
+    type,
+    range,
+    speed,
+    error,
+    attack,
+    health,
+    is_head,
+    player,
+    points,
+    err_code,
+    zombies,
+    wait_turns,
+    direction,
+    last_attack,
+    game_ended_at,
+    enemy_blocks,
+    zombie_kills,
+    turn_ends_in_ms,
+    enemy_block_kills,
+  };
+
+  static Field intern_field(std::string_view key) {
+    switch (key.size()) {
+      case 1:
+        if (key[0] == 'x') return Field::x;
+        if (key[0] == 'y') return Field::y;
+        break;
+      case 2:
+        if (key == "id") return Field::id;
+        break;
+      case 4:
+        if (key == "base") return Field::base;
+        if (key == "turn") return Field::turn;
+        if (key == "gold") return Field::gold;
+        if (key == "name") return Field::name;
+        if (key == "type") return Field::type;
+        break;
+      case 5:
+        if (key == "range") return Field::range;
+        if (key == "speed") return Field::speed;
+        if (key == "error") return Field::error;
+        break;
+      case 6:
+        if (key == "attack") return Field::attack;
+        if (key == "health") return Field::health;
+        if (key == "isHead") return Field::is_head;
+        if (key == "player") return Field::player;
+        if (key == "points") return Field::points;
+        break;
+      case 7:
+        if (key == "errCode") return Field::err_code;
+        if (key == "zombies") return Field::zombies;
+        break;
+      case 9:
+        if (key == "waitTurns") return Field::wait_turns;
+        if (key == "direction") return Field::direction;
+        break;
+      case 10:
+        if (key == "lastAttack") return Field::last_attack;
+        break;
+      case 11:
+        if (key == "gameEndedAt") return Field::game_ended_at;
+        if (key == "enemyBlocks") return Field::enemy_blocks;
+        if (key == "zombieKills") return Field::zombie_kills;
+        break;
+      case 12:
+        if (key == "turnEndsInMs") return Field::turn_ends_in_ms;
+        break;
+      case 15:
+        if (key == "enemyBlockKills") return Field::enemy_block_kills;
+        break;
+      default: break;
+    }
+    return Field::unknown;
+  }
+
+  static Zombie::Type intern_zombie_type(std::string_view type) {
+    if (type == "normal") return Zombie::Type::normal;
+    if (type == "fast") return Zombie::Type::fast;
+    if (type == "bomber") return Zombie::Type::bomber;
+    if (type == "liner") return Zombie::Type::liner;
+    if (type == "juggernaut") return Zombie::Type::juggernaut;
+    if (type == "chaos_knight") return Zombie::Type::chaos_knight;
+    throw std::out_of_range("UNKNOWN ZOMBIE TYPE: " + std::string(type));
+  }
+
+  [[nodiscard]] Scope scope() const { return depth_ > 0 ? scopes_[depth_ - 1] : Scope::none; }
+
+  void push(Scope scope) {
+    if (depth_ == scopes_.size()) {
+      skip_depth_ = 1;
+      return;
+    }
+    scopes_[depth_++] = scope;
+  }
+
+  void start_building(Building& building, bool is_enemy) {
+    building_ = &building;
+    building_->is_enemy = is_enemy;
+    has_is_head_ = false;
+    has_range_ = false;
+  }
+
+  void finish_building() {
+    if (!has_is_head_) {
+      building_->is_head = building_->attack > 20;  // todo: wtf? =(
+    }
+    if (!has_range_) {
+      building_->range = building_->is_head ? 10 : 8;
+    }
+  }
+
+  void on_int(int value) {
+    if (skip_depth_ > 0) {
+      return;
+    }
+    switch (scope()) {
+      case Scope::root:
+        switch (field_) {
+          case Field::turn: out_->turn = value; break;
+          case Field::turn_ends_in_ms: out_->turn_ends_in_ms = value; break;
+          case Field::err_code: out_->err_code = value; break;
+          default: break;
+        }
+        break;
+      case Scope::player:
+        switch (field_) {
+          case Field::gold: out_->player.gold = value; break;
+          case Field::enemy_block_kills: out_->player.enemy_block_kills = value; break;
+          case Field::points: out_->player.points = value; break;
+          case Field::zombie_kills: out_->player.zombie_kills = value; break;
+          default: break;
+        }
+        break;
+      case Scope::building:
+        switch (field_) {
+          case Field::attack: building_->attack = value; break;
+          case Field::health: building_->health = value; break;
+          case Field::range:
+            building_->range = value;
+            has_range_ = true;
+            break;
+          case Field::x: building_->position.x = value; break;
+          case Field::y: building_->position.y = value; break;
+          default: break;
+        }
+        break;
+      case Scope::last_attack:
+        switch (field_) {
+          case Field::x: building_->last_attack->x = value; break;
+          case Field::y: building_->last_attack->y = value; break;
+          default: break;
+        }
+        break;
+      case Scope::zombie:
+        switch (field_) {
+          case Field::attack: zombie_->attack = value; break;
+          case Field::health: zombie_->health = value; break;
+          case Field::wait_turns: zombie_->wait_turns = value; break;
+          case Field::speed: zombie_->speed = value; break;
+          case Field::x: zombie_->position.x = value; break;
+          case Field::y: zombie_->position.y = value; break;
+          default: break;
+        }
+        break;
+      default: break;
+    }
+  }
+
+  void on_string(std::string_view value) {
+    switch (scope()) {
+      case Scope::root:
+        if (field_ == Field::error) {
+          out_->err_message.emplace(value);
+        }
+        break;
+      case Scope::player:
+        if (field_ == Field::name) {
+          out_->player.name.assign(value);
+        } else if (field_ == Field::game_ended_at) {
+          out_->game_ended_at.emplace(value);
+        }
+        break;
+      case Scope::building:
+        if (field_ == Field::name) {
+          building_->player_name.assign(value);
+        } else if (field_ == Field::id) {
+          building_->id.assign(value);
+        }
+        break;
+      case Scope::zombie:
+        if (field_ == Field::id) {
+          zombie_->id.assign(value);
+        } else if (field_ == Field::type) {
+          zombie_->type = intern_zombie_type(value);
+        } else if (field_ == Field::direction) {
+          if (value == "up") {
+            zombie_->direction = vec2i(0, -1);
+          } else if (value == "down") {
+            zombie_->direction = vec2i(0, 1);
+          } else if (value == "left") {
+            zombie_->direction = vec2i(-1, 0);
+          } else if (value == "right") {
+            zombie_->direction = vec2i(1, 0);
+          }
+        }
+        break;
+      default: break;
+    }
+  }
+
+  rapidjson::Reader reader_;
+  UnitsSnapshot* out_ = nullptr;
+  std::array<Scope, 8> scopes_{};
+  size_t depth_ = 0;
+  size_t skip_depth_ = 0;
+  Field field_ = Field::unknown;
+  Building* building_ = nullptr;
+  Zombie* zombie_ = nullptr;
+  bool has_is_head_ = false;
+  bool has_range_ = false;
+  rapidjson::ParseErrorCode error_code_ = rapidjson::kParseErrorNone;
+  size_t error_offset_ = 0;
+};
+
+}  // namespace mortido::models
@@ -0,0 +1,172 @@
+#pragma once
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <string>
+#include <string_view>
+
+#include "models/units_reader.h"
+
+namespace mortido::models {
+
+// Serializes a UnitsSnapshot back into a `/units` body, the inverse of UnitsReader: the text
+// differs from the server's (field order, fields UnitsReader skips), but reading it back gives
+// the same snapshot. The returned view is valid until the next encode() call.
+class UnitsWriter {
+ public:
+  UnitsWriter() : writer_(buffer_) {}
+
+  std::string_view encode(const UnitsSnapshot& units) {
+    buffer_.Clear();
+    writer_.Reset(buffer_);
+
+    writer_.StartObject();
+    writer_.Key("base");
+    writer_.StartArray();
+    for (const auto& building : units.base) {
+      write_building(building);
+    }
+    writer_.EndArray();
+    writer_.Key("enemyBlocks");
+    writer_.StartArray();
+    for (const auto& building : units.enemy_blocks) {
+      write_building(building);
+    }
+    writer_.EndArray();
+
+    writer_.Key("player");
+    writer_.StartObject();
+    writer_.Key("enemyBlockKills");
+    writer_.Int(units.player.enemy_block_kills);
+    writer_.Key("gameEndedAt");
+    if (units.game_ended_at) {
+      write_string(*units.game_ended_at);
+    } else {
+      writer_.Null();
+    }
+    writer_.Key("gold");
+    writer_.Int(units.player.gold);
+    writer_.Key("name");
+    write_string(units.player.name);
+    writer_.Key("points");
+    writer_.Int(units.player.points);
+    writer_.Key("zombieKills");
+    writer_.Int(units.player.zombie_kills);
+    writer_.EndObject();
+
+    if (units.turn) {
+      writer_.Key("turn");
+      writer_.Int(*units.turn);
+    }
+    writer_.Key("turnEndsInMs");
+    writer_.Int(units.turn_ends_in_ms);
+
+    writer_.Key("zombies");
+    writer_.StartArray();
+    for (const auto& zombie : units.zombies) {
+      write_zombie(zombie);
+    }
+    writer_.EndArray();
+
+    if (units.err_code) {
+      writer_.Key("errCode");
+      writer_.Int(*units.err_code);
+    }
+    if (units.err_message) {
+      writer_.Key("error");
+      write_string(*units.err_message);
+    }
+    writer_.EndObject();
+
+    return {buffer_.GetString(), buffer_.GetSize()};
+  }
+
+ private:
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+
+  void write_string(std::string_view value) {
+    writer_.String(value.data(), static_cast<rapidjson::SizeType>(value.size()));
+  }
+
+  void write_building(const Building& building) {
+    writer_.StartObject();
+    writer_.Key("attack");
+    writer_.Int(building.attack);
+    writer_.Key("health");
+    writer_.Int(building.health);
+    writer_.Key("id");
+    write_string(building.id);
+    writer_.Key("isHead");
+    writer_.Bool(building.is_head);
+    writer_.Key("lastAttack");
+    if (building.last_attack) {
+      writer_.StartObject();
+      writer_.Key("x");
+      writer_.Int(building.last_attack->x);
+      writer_.Key("y");
+      writer_.Int(building.last_attack->y);
+      writer_.EndObject();
+    } else {
+      writer_.Null();
+    }
+    if (!building.player_name.empty()) {
+      writer_.Key("name");
+      write_string(building.player_name);
+    }
+    writer_.Key("range");
+    writer_.Int(building.range);
+    writer_.Key("x");
+    writer_.Int(building.position.x);
+    writer_.Key("y");
+    writer_.Int(building.position.y);
+    writer_.EndObject();
+  }
+
+  void write_zombie(const Zombie& zombie) {
+    writer_.StartObject();
+    writer_.Key("attack");
+    writer_.Int(zombie.attack);
+    if (const char* direction = direction_name(zombie.direction)) {
+      writer_.Key("direction");
+      writer_.String(direction);
+    }
+    writer_.Key("health");
+    writer_.Int(zombie.health);
+    writer_.Key("id");
+    write_string(zombie.id);
+    writer_.Key("speed");
+    writer_.Int(zombie.speed);
+    writer_.Key("type");
+    writer_.String(type_name(zombie.type));
+    writer_.Key("waitTurns");
+    writer_.Int(zombie.wait_turns);
+    writer_.Key("x");
+    writer_.Int(zombie.position.x);
+    writer_.Key("y");
+    writer_.Int(zombie.position.y);
+    writer_.EndObject();
+  }
+
+  static const char* direction_name(vec2i direction) {
+    if (direction == vec2i(0, -1)) return "up";
+    if (direction == vec2i(0, 1)) return "down";
+    if (direction == vec2i(-1, 0)) return "left";
+    if (direction == vec2i(1, 0)) return "right";
+    return nullptr;
+  }
+
+  static const char* type_name(Zombie::Type type) {
+    switch (type) {
+      case Zombie::Type::normal: return "normal";
+      case Zombie::Type::fast: return "fast";
+      case Zombie::Type::bomber: return "bomber";
+      case Zombie::Type::liner: return "liner";
+      case Zombie::Type::juggernaut: return "juggernaut";
+      case Zombie::Type::chaos_knight: return "chaos_knight";
+    }
+    return "normal";
+  }
+};
+
+}  // namespace mortido::models
@@ -1,6 +1,7 @@
 #pragma once
 #include <rapidjson/document.h>
 
+#include <queue>
 #include <random>
 #include <string>
 #include <unordered_map>
@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "alloc.h"
+#include "trace.h"
+
+namespace mortido::perf {
+
+// Turn phases timed with PERF_SCOPE. They nest: `turn` spans load_units through send_command,
+// load_units contains parse and update_state, update_state contains map_update.
+enum class Phase {
+  turn,
+  load_units,
+  parse,
+  update_state,
+  map_update,
+  attack,
+  build,
+  move_base,
+  send_command,
+  draw,
+  count,
+};
+
+inline const char* phase_name(Phase phase) {
+  switch (phase) {
+    case Phase::turn: return "turn";
+    case Phase::load_units: return "load_units";
+    case Phase::parse: return "parse";
+    case Phase::update_state: return "update_state";
+    case Phase::map_update: return "map_update";
+    case Phase::attack: return "attack";
+    case Phase::build: return "build";
+    case Phase::move_base: return "move_base";
+    case Phase::send_command: return "send_command";
+    case Phase::draw: return "draw";
+    case Phase::count: break;
+  }
+  return "?";
+}
+
+// Log-bucketed latency histogram in nanoseconds, HDR style: every power of two is split into
+// kSubBuckets linear buckets, so any recorded value is known within 1/kSubBuckets (12.5%).
+// record() is a few relaxed atomic adds and never blocks; readers may see a recording in
+// progress, which is fine for reporting.
+class Histogram {
+ public:
+  constexpr static int kSubBits = 3;
+  constexpr static uint64_t kSubBuckets = 1 << kSubBits;
+  constexpr static size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+  void record(uint64_t ns) {
+    buckets_[index(ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (ns > max && !max_.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+  }
+
+  void reset() {
+    for (auto& bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  [[nodiscard]] uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  [[nodiscard]] uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  [[nodiscard]] uint64_t bucket(size_t i) const {
+    return buckets_[i].load(std::memory_order_relaxed);
+  }
+
+  // Highest value of the bucket holding the q-th quantile, clamped to the recorded max.
+  [[nodiscard]] uint64_t percentile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+      return 0;
+    }
+    auto rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; i++) {
+      seen += bucket(i);
+      if (seen >= rank) {
+        return std::min(lower_bound(i + 1) - 1, max());
+      }
+    }
+    return max();
+  }
+
+  static size_t index(uint64_t ns) {
+    if (ns < kSubBuckets) {
+      return ns;
+    }
+    int exponent = std::bit_width(ns) - 1;
+    uint64_t mantissa = (ns >> (exponent - kSubBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBits + 1) * kSubBuckets + mantissa;
+  }
+
+  static uint64_t lower_bound(size_t i) {
+    if (i < kSubBuckets) {
+      return i;
+    }
+    if (i >= kBuckets) {
+      return UINT64_MAX;
+    }
+    int exponent = static_cast<int>(i / kSubBuckets) + kSubBits - 1;
+    return (kSubBuckets + i % kSubBuckets) << (exponent - kSubBits);
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+// Heap allocations made inside one phase, summed over its calls. Only non-zero in binaries
+// that count allocations (alloc.h).
+class AllocStats {
+ public:
+  void record(const alloc::Counters& delta) {
+    calls_.fetch_add(1, std::memory_order_relaxed);
+    allocations_.fetch_add(delta.allocations, std::memory_order_relaxed);
+    bytes_.fetch_add(delta.bytes, std::memory_order_relaxed);
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (delta.allocations > max &&
+           !max_.compare_exchange_weak(max, delta.allocations, std::memory_order_relaxed)) {
+    }
+  }
+
+  void reset() {
+    calls_.store(0, std::memory_order_relaxed);
+    allocations_.store(0, std::memory_order_relaxed);
+    bytes_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] uint64_t calls() const { return calls_.load(std::memory_order_relaxed); }
+  [[nodiscard]] uint64_t allocations() const {
+    return allocations_.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+  // Most allocations in a single call.
+  [[nodiscard]] uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> calls_{0};
+  std::atomic<uint64_t> allocations_{0};
+  std::atomic<uint64_t> bytes_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+// One histogram and allocation count per phase for one game.
+class Profile {
+ public:
+  void record(Phase phase, uint64_t ns) { histograms_[static_cast<size_t>(phase)].record(ns); }
+  void record(Phase phase, const alloc::Counters& delta) {
+    allocs_[static_cast<size_t>(phase)].record(delta);
+  }
+
+  [[nodiscard]] const Histogram& histogram(Phase phase) const {
+    return histograms_[static_cast<size_t>(phase)];
+  }
+  [[nodiscard]] const AllocStats& allocs(Phase phase) const {
+    return allocs_[static_cast<size_t>(phase)];
+  }
+
+  void reset() {
+    for (auto& histogram : histograms_) {
+      histogram.reset();
+    }
+    for (auto& allocs : allocs_) {
+      allocs.reset();
+    }
+  }
+
+  // Summary table (count, p50, p90, p99, max, mean in microseconds), then, if allocations were
+  // counted, allocations and KB per call of every phase (per turn for `turn`), then the
+  // non-empty buckets of every phase as "bucket <phase> <lower bound ns> <count>", enough to
+  // merge games or recompute any percentile.
+  bool write(const std::filesystem::path& path, const std::string& title) const {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+      return false;
+    }
+    std::fprintf(file, "# %s\n", title.c_str());
+    std::fprintf(file, "%-14s %8s %10s %10s %10s %10s %10s\n", "phase", "count", "p50_us",
+                 "p90_us", "p99_us", "max_us", "mean_us");
+    for_each([&](Phase phase, const Histogram& h) {
+      double mean = static_cast<double>(h.sum()) / static_cast<double>(h.count());
+      std::fprintf(file, "%-14s %8llu %10.1f %10.1f %10.1f %10.1f %10.1f\n", phase_name(phase),
+                   static_cast<unsigned long long>(h.count()), us(h.percentile(0.5)),
+                   us(h.percentile(0.9)), us(h.percentile(0.99)), us(h.max()), mean / 1e3);
+    });
+    std::fprintf(file, "\n");
+    if (counted_allocations()) {
+      std::fprintf(file, "%-14s %8s %12s %10s %10s\n", "phase", "calls", "allocs/call",
+                   "KB/call", "max_allocs");
+      for_each([&](Phase phase, const Histogram&) {
+        const auto& a = allocs(phase);
+        auto calls = static_cast<double>(std::max<uint64_t>(1, a.calls()));
+        std::fprintf(file, "%-14s %8llu %12.1f %10.1f %10llu\n", phase_name(phase),
+                     static_cast<unsigned long long>(a.calls()),
+                     static_cast<double>(a.allocations()) / calls,
+                     static_cast<double>(a.bytes()) / calls / 1024.0,
+                     static_cast<unsigned long long>(a.max()));
+      });
+      std::fprintf(file, "\n");
+    }
+    for_each([&](Phase phase, const Histogram& h) {
+      for (size_t i = 0; i < Histogram::kBuckets; i++) {
+        if (uint64_t n = h.bucket(i)) {
+          std::fprintf(file, "bucket %s %llu %llu\n", phase_name(phase),
+                       static_cast<unsigned long long>(Histogram::lower_bound(i)),
+                       static_cast<unsigned long long>(n));
+        }
+      }
+    });
+    std::fclose(file);
+    return true;
+  }
+
+  // Calls fn(phase, histogram) for the phases that recorded anything.
+  template <typename F>
+  void for_each(F&& fn) const {
+    for (size_t i = 0; i < histograms_.size(); i++) {
+      if (histograms_[i].count() > 0) {
+        fn(static_cast<Phase>(i), histograms_[i]);
+      }
+    }
+  }
+
+ private:
+  std::array<Histogram, static_cast<size_t>(Phase::count)> histograms_;
+  std::array<AllocStats, static_cast<size_t>(Phase::count)> allocs_;
+
+  [[nodiscard]] bool counted_allocations() const {
+    return std::any_of(allocs_.begin(), allocs_.end(),
+                       [](const AllocStats& a) { return a.allocations() > 0; });
+  }
+
+  static double us(uint64_t ns) { return static_cast<double>(ns) / 1e3; }
+};
+
+// Profile that PERF_SCOPE records into on this thread, none by default: timers are then a
+// single branch. Set for the duration of a game with BindProfile.
+inline thread_local Profile* active_profile = nullptr;
+
+class BindProfile {
+ public:
+  explicit BindProfile(Profile& profile) : previous_(active_profile) {
+    active_profile = &profile;
+  }
+  ~BindProfile() { active_profile = previous_; }
+
+  BindProfile(const BindProfile&) = delete;
+  BindProfile& operator=(const BindProfile&) = delete;
+
+ private:
+  Profile* previous_;
+};
+
+// Also counts the allocations of the scope (alloc.h). With -DTRACE every timed scope is also a
+// trace span.
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Phase phase) : profile_(active_profile), phase_(phase) {
+    if (profile_) {
+      allocs_ = alloc::counters();
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~ScopedTimer() {
+    if (profile_) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_)
+                    .count();
+      profile_->record(phase_, static_cast<uint64_t>(ns));
+      profile_->record(phase_, alloc::counters() - allocs_);
+    }
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Profile* profile_;
+  Phase phase_;
+  std::chrono::steady_clock::time_point start_;
+  alloc::Counters allocs_;
+#ifdef TRACE
+  trace::Span span_{phase_name(phase_)};
+#endif
+};
+
+}  // namespace mortido::perf
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+// Times the rest of the enclosing scope as `phase` (a perf::Phase enumerator name).
+#define PERF_SCOPE(phase) \
+  ::mortido::perf::ScopedTimer PERF_CONCAT(perf_timer_, __LINE__)(::mortido::perf::Phase::phase)
@@ -0,0 +1,585 @@
+#include "sim/engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mortido::sim {
+
+using models::vec2i;
+using ZombieType = models::Zombie::Type;
+
+namespace {
+
+const std::array<vec2i, 4> kStraight = {vec2i{-1, 0}, vec2i{1, 0}, vec2i{0, -1}, vec2i{0, 1}};
+const std::array<vec2i, 4> kDiagonal = {vec2i{-1, -1}, vec2i{-1, 1}, vec2i{1, 1}, vec2i{1, -1}};
+
+const char* type_name(ZombieType type) {
+  switch (type) {
+    case ZombieType::normal: return "normal";
+    case ZombieType::fast: return "fast";
+    case ZombieType::bomber: return "bomber";
+    case ZombieType::liner: return "liner";
+    case ZombieType::juggernaut: return "juggernaut";
+    case ZombieType::chaos_knight: return "chaos_knight";
+  }
+  return "normal";
+}
+
+const char* direction_name(vec2i dir) {
+  if (dir.y < 0) return "up";
+  if (dir.y > 0) return "down";
+  if (dir.x < 0) return "left";
+  return "right";
+}
+
+}  // namespace
+
+Engine::Engine(const Config& config)
+    : config_(config)
+    , rng_(config.seed)
+    , name_("sim-" + std::to_string(config.seed))
+    , writer_(buffer_) {
+  size_t cells = static_cast<size_t>(config_.size.x) * config_.size.y;
+  cells_.assign(cells, CellType::normal);
+  block_at_.assign(cells, -1);
+  zombie_head_.assign(cells, -1);
+  generate();
+}
+
+std::string Engine::make_id(char kind) {
+  return std::string("sim-") + kind + "-" + std::to_string(next_id_++);
+}
+
+size_t Engine::block_count(int owner) const {
+  return std::count_if(blocks_.begin(), blocks_.end(),
+                       [owner](const Block& b) { return b.owner == owner; });
+}
+
+void Engine::generate() {
+  auto random_pos = [&](int margin) {
+    return vec2i{margin + random(config_.size.x - 2 * margin),
+                 margin + random(config_.size.y - 2 * margin)};
+  };
+  std::vector<vec2i> bases;
+  auto far_from_bases = [&](vec2i pos, int distance) {
+    return std::all_of(bases.begin(), bases.end(), [&](vec2i base) {
+      return (base - pos).sq_length() >= distance * distance;
+    });
+  };
+
+  players_.emplace_back().name = "mortido";
+  players_.back().gold = config_.start_gold;
+  bases.push_back(random_pos(config_.size.x / 3));
+  for (int i = 0; i < config_.enemies; i++) {
+    vec2i pos = random_pos(5);
+    for (int attempt = 0; attempt < 100 && !far_from_bases(pos, 30); attempt++) {
+      pos = random_pos(5);
+    }
+    players_.emplace_back().name = "sim-enemy-" + std::to_string(i + 1);
+    bases.push_back(pos);
+  }
+
+  for (int i = 0; i < config_.walls + config_.spawns; i++) {
+    vec2i pos = random_pos(0);
+    if (!far_from_bases(pos, 8) || cells_[cell(pos)] != CellType::normal) {
+      continue;
+    }
+    if (i < config_.spawns) {
+      cells_[cell(pos)] = CellType::spawn;
+      spawns_.push_back(pos);
+    } else {
+      cells_[cell(pos)] = CellType::wall;
+      walls_.push_back(pos);
+    }
+  }
+
+  // Ours starts as a 2x2 square, enemies as a plus.
+  add_block(bases[kUs], kUs, true);
+  for (vec2i shift : {vec2i{1, 0}, vec2i{0, 1}, vec2i{1, 1}}) {
+    add_block(bases[kUs] + shift, kUs, false);
+  }
+  for (int owner = 1; owner < static_cast<int>(bases.size()); owner++) {
+    add_block(bases[owner], owner, true);
+    for (vec2i dir : kStraight) {
+      add_block(bases[owner] + dir, owner, false);
+    }
+  }
+}
+
+void Engine::add_block(vec2i pos, int owner, bool is_head) {
+  block_at_[cell(pos)] = static_cast<int>(blocks_.size());
+  blocks_.push_back(Block{
+      .id = make_id('b'),
+      .pos = pos,
+      .owner = owner,
+      .attack = is_head ? config_.head_attack : config_.block_attack,
+      .health = is_head ? config_.head_health : config_.block_health,
+      .range = is_head ? config_.head_range : config_.block_range,
+      .is_head = is_head,
+      .attacked = false,
+      .last_attack = std::nullopt,
+  });
+}
+
+void Engine::step(const api::Command& command) {
+  if (ended_) {
+    return;
+  }
+  for (auto& block : blocks_) {
+    block.attacked = false;
+    block.last_attack.reset();
+  }
+
+  if (command.move_base) {
+    move_base(*command.move_base);
+  }
+  mark_active();
+  for (const auto& attack_command : command.attack) {
+    auto it = std::find_if(blocks_.begin(), blocks_.end(), [&](const Block& b) {
+      return b.owner == kUs && b.id == attack_command.block_id;
+    });
+    if (it != blocks_.end() && active_[it - blocks_.begin()]) {
+      attack(*it, attack_command.target);
+    }
+  }
+  enemy_attacks();
+  for (const auto& pos : command.build) {
+    build(pos);
+  }
+  remove_dead();
+
+  move_zombies();
+  remove_dead();
+  spawn_zombies();
+  index_zombies();
+
+  turn_++;
+  if (turn_ >= config_.max_turns && players_[kUs].alive) {
+    players_[kUs].ended_at_turn = turn_;
+  }
+  ended_ = players_[kUs].ended_at_turn.has_value();
+}
+
+// Rebuilt from scratch: zombies move and die between two indexings, so resetting only the
+// cells they are on now would leave stale heads behind.
+void Engine::index_zombies() {
+  std::fill(zombie_head_.begin(), zombie_head_.end(), -1);
+  zombie_next_.assign(zombies_.size(), -1);
+  for (size_t i = 0; i < zombies_.size(); i++) {
+    auto& head = zombie_head_[cell(zombies_[i].pos)];
+    zombie_next_[i] = head;
+    head = static_cast<int>(i);
+  }
+}
+
+bool Engine::zombie_index_valid() const {
+  if (zombie_next_.size() != zombies_.size()) {
+    return false;
+  }
+  size_t listed = 0;
+  for (size_t c = 0; c < zombie_head_.size(); c++) {
+    for (int z = zombie_head_[c]; z >= 0; z = zombie_next_[z]) {
+      if (static_cast<size_t>(z) >= zombies_.size() || cell(zombies_[z].pos) != c ||
+          ++listed > zombies_.size()) {
+        return false;
+      }
+    }
+  }
+  return listed == zombies_.size();
+}
+
+void Engine::mark_active() {
+  active_.assign(blocks_.size(), 0);
+  bfs_.clear();
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    if (blocks_[i].owner == kUs && blocks_[i].is_head) {
+      active_[i] = 1;
+      bfs_.push_back(static_cast<int>(i));
+    }
+  }
+  for (size_t k = 0; k < bfs_.size(); k++) {
+    vec2i pos = blocks_[bfs_[k]].pos;
+    for (vec2i dir : kStraight) {
+      vec2i next = pos + dir;
+      if (!in_bounds(next)) continue;
+      int b = block_at_[cell(next)];
+      if (b >= 0 && blocks_[b].owner == kUs && !active_[b]) {
+        active_[b] = 1;
+        bfs_.push_back(b);
+      }
+    }
+  }
+}
+
+void Engine::move_base(const vec2i& target) {
+  if (!in_bounds(target)) return;
+  int to = block_at_[cell(target)];
+  if (to < 0 || blocks_[to].owner != kUs || blocks_[to].is_head) return;
+  for (auto& from : blocks_) {
+    if (from.owner == kUs && from.is_head) {
+      from.is_head = false;
+      from.attack = config_.block_attack;
+      from.range = config_.block_range;
+      from.health = std::min(from.health, config_.block_health);
+    }
+  }
+  auto& head = blocks_[to];
+  head.is_head = true;
+  head.attack = config_.head_attack;
+  head.range = config_.head_range;
+}
+
+void Engine::attack(Block& block, vec2i target) {
+  if (block.attacked || block.health <= 0 || !in_bounds(target) ||
+      (target - block.pos).sq_length() > block.range * block.range) {
+    return;
+  }
+  block.attacked = true;
+  block.last_attack = target;
+  auto& player = players_[block.owner];
+
+  for (int z = zombie_head_[cell(target)]; z >= 0; z = zombie_next_[z]) {
+    auto& zombie = zombies_[z];
+    if (zombie.health > 0 && zombie.health <= block.attack) {
+      player.zombie_kills++;
+      player.points++;
+      player.gold += config_.zombie_kill_gold;
+    }
+    zombie.health -= block.attack;
+  }
+  int b = block_at_[cell(target)];
+  if (b >= 0 && blocks_[b].owner != block.owner && blocks_[b].health > 0) {
+    auto& victim = blocks_[b];
+    victim.health -= block.attack;
+    if (victim.health <= 0) {
+      player.block_kills++;
+      player.points += victim.is_head ? 10 : 1;
+      player.gold += victim.is_head ? config_.head_kill_gold : config_.block_kill_gold;
+    }
+  }
+}
+
+void Engine::enemy_attacks() {
+  for (auto& block : blocks_) {
+    if (block.owner == kUs || block.health <= 0) continue;
+    int range_sq = block.range * block.range;
+
+    // Our blocks first, the closest one, then any zombie in range.
+    std::optional<vec2i> target;
+    int best = range_sq + 1;
+    for (const auto& other : blocks_) {
+      int distance = (other.pos - block.pos).sq_length();
+      if (other.owner != block.owner && other.health > 0 && distance < best) {
+        best = distance;
+        target = other.pos;
+      }
+    }
+    if (!target) {
+      for (const auto& zombie : zombies_) {
+        if (zombie.health > 0 && (zombie.pos - block.pos).sq_length() <= range_sq) {
+          target = zombie.pos;
+          break;
+        }
+      }
+    }
+    if (target) {
+      attack(block, *target);
+    }
+  }
+}
+
+// Same rules as models::Map::can_build, plus: next to one of our blocks and not on a zombie.
+bool Engine::can_build(vec2i pos) const {
+  if (!is_free(pos) || zombie_head_[cell(pos)] >= 0) {
+    return false;
+  }
+  bool connected = false;
+  for (vec2i dir : kStraight) {
+    vec2i next = pos + dir;
+    if (!in_bounds(next)) continue;
+    if (cells_[cell(next)] != CellType::normal) return false;
+    int b = block_at_[cell(next)];
+    if (b >= 0 && blocks_[b].owner != kUs) return false;
+    connected = connected || (b >= 0 && blocks_[b].health > 0);
+  }
+  for (vec2i dir : kDiagonal) {
+    vec2i next = pos + dir;
+    if (!in_bounds(next)) continue;
+    int b = block_at_[cell(next)];
+    if (b >= 0 && blocks_[b].owner != kUs) return false;
+  }
+  return connected;
+}
+
+void Engine::build(vec2i pos) {
+  if (players_[kUs].gold <= 0 || !can_build(pos)) {
+    return;
+  }
+  players_[kUs].gold--;
+  add_block(pos, kUs, false);
+}
+
+void Engine::move_zombies() {
+  for (auto& zombie : zombies_) {
+    if (zombie.health <= 0 || --zombie.wait_left > 0) {
+      continue;
+    }
+    zombie.wait_left = zombie.wait_turns;
+    if (zombie.type == ZombieType::chaos_knight) {
+      jump(zombie);
+      continue;
+    }
+    for (int step = 0; step < zombie.speed && advance(zombie); step++) {
+    }
+  }
+}
+
+// Moves the zombie one cell, returns false if it stopped or died.
+bool Engine::advance(Zombie& zombie) {
+  vec2i next = zombie.pos + zombie.dir;
+  if (!in_bounds(next) || cells_[cell(next)] != CellType::normal) {
+    zombie.health = 0;
+    return false;
+  }
+  int b = block_at_[cell(next)];
+  if (b < 0 || blocks_[b].health <= 0) {
+    zombie.pos = next;
+    return true;
+  }
+
+  switch (zombie.type) {
+    case ZombieType::bomber:
+      hit(next, zombie.attack);
+      for (vec2i dir : kStraight) hit(next + dir, zombie.attack);
+      for (vec2i dir : kDiagonal) hit(next + dir, zombie.attack);
+      zombie.health = 0;
+      return false;
+    case ZombieType::liner:
+      for (vec2i pos = next; in_bounds(pos) && block_at_[cell(pos)] >= 0; pos += zombie.dir) {
+        hit(pos, zombie.attack);
+      }
+      zombie.health = 0;
+      return false;
+    case ZombieType::juggernaut:
+      hit(next, zombie.attack);
+      zombie.pos = next;
+      return true;
+    default: hit(next, zombie.attack); return false;
+  }
+}
+
+void Engine::jump(Zombie& zombie) {
+  vec2i side = random(2) ? zombie.dir.rotated90ccw() : zombie.dir.rotated90cw();
+  vec2i landing = zombie.pos + zombie.dir * 2 + side;
+  zombie.dir = side;
+  if (!in_bounds(landing) || cells_[cell(landing)] != CellType::normal) {
+    zombie.health = 0;
+    return;
+  }
+  int b = block_at_[cell(landing)];
+  if (b >= 0 && blocks_[b].health > 0) {
+    hit(landing, zombie.attack);
+  } else {
+    zombie.pos = landing;
+  }
+}
+
+void Engine::hit(vec2i pos, int damage) {
+  if (!in_bounds(pos)) return;
+  int b = block_at_[cell(pos)];
+  if (b >= 0) {
+    blocks_[b].health -= damage;
+  }
+}
+
+void Engine::remove_dead() {
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    const auto& block = blocks_[i];
+    if (block.health <= 0 && block.is_head && players_[block.owner].alive) {
+      // Losing the head ends the game for its owner, the rest of the base goes with it.
+      auto& owner = players_[block.owner];
+      owner.alive = false;
+      owner.ended_at_turn = turn_;
+    }
+  }
+
+  for (const auto& block : blocks_) {
+    block_at_[cell(block.pos)] = -1;
+  }
+  std::erase_if(blocks_, [&](const Block& b) { return b.health <= 0 || !players_[b.owner].alive; });
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    block_at_[cell(blocks_[i].pos)] = static_cast<int>(i);
+  }
+
+  std::erase_if(zombies_, [](const Zombie& z) { return z.health <= 0; });
+}
+
+void Engine::spawn_zombies() {
+  double probability = static_cast<double>(std::min((turn_ + 5) / 6, 50)) * 0.01;
+  double growth = 1.0 + config_.zombie_growth * turn_;
+  int total_weight = 0;
+  for (const auto& proto : config_.zombies) {
+    total_weight += proto.weight;
+  }
+  std::uniform_real_distribution<double> roll(0.0, 1.0);
+
+  for (vec2i spawn : spawns_) {
+    if (roll(rng_) >= probability || total_weight <= 0) {
+      continue;
+    }
+    int pick = random(total_weight);
+    size_t type = 0;
+    while (pick >= config_.zombies[type].weight) {
+      pick -= config_.zombies[type].weight;
+      type++;
+    }
+    const auto& proto = config_.zombies[type];
+    zombies_.push_back(Zombie{
+        .id = make_id('z'),
+        .type = static_cast<ZombieType>(type),
+        .pos = spawn,
+        .dir = kStraight[random(4)],
+        .attack = static_cast<int>(std::lround(proto.attack * growth)),
+        .health = static_cast<int>(std::lround(proto.health * growth)),
+        .speed = proto.speed,
+        .wait_turns = proto.wait_turns,
+        .wait_left = proto.wait_turns,
+    });
+  }
+}
+
+void Engine::write_world(std::string& out) {
+  buffer_.Clear();
+  writer_.Reset(buffer_);
+  writer_.StartObject();
+  writer_.Key("realmName");
+  writer_.String(name_.c_str());
+  writer_.Key("zpots");
+  writer_.StartArray();
+  auto write_spot = [&](vec2i pos, const char* type) {
+    writer_.StartObject();
+    writer_.Key("x");
+    writer_.Int(pos.x);
+    writer_.Key("y");
+    writer_.Int(pos.y);
+    writer_.Key("type");
+    writer_.String(type);
+    writer_.EndObject();
+  };
+  for (vec2i spawn : spawns_) write_spot(spawn, "default");
+  for (vec2i wall : walls_) write_spot(wall, "wall");
+  writer_.EndArray();
+  writer_.EndObject();
+  out.assign(buffer_.GetString(), buffer_.GetSize());
+}
+
+void Engine::write_units(std::string& out) {
+  buffer_.Clear();
+  writer_.Reset(buffer_);
+  const auto& me = players_[kUs];
+
+  auto write_block = [&](const Block& block) {
+    writer_.StartObject();
+    writer_.Key("attack");
+    writer_.Int(block.attack);
+    writer_.Key("health");
+    writer_.Int(block.health);
+    writer_.Key("id");
+    writer_.String(block.id.c_str());
+    writer_.Key("isHead");
+    writer_.Bool(block.is_head);
+    writer_.Key("lastAttack");
+    if (block.last_attack) {
+      writer_.StartObject();
+      writer_.Key("x");
+      writer_.Int(block.last_attack->x);
+      writer_.Key("y");
+      writer_.Int(block.last_attack->y);
+      writer_.EndObject();
+    } else {
+      writer_.Null();
+    }
+    if (block.owner != kUs) {
+      writer_.Key("name");
+      writer_.String(players_[block.owner].name.c_str());
+    }
+    writer_.Key("range");
+    writer_.Int(block.range);
+    writer_.Key("x");
+    writer_.Int(block.pos.x);
+    writer_.Key("y");
+    writer_.Int(block.pos.y);
+    writer_.EndObject();
+  };
+
+  writer_.StartObject();
+  writer_.Key("base");
+  writer_.StartArray();
+  for (const auto& block : blocks_) {
+    if (block.owner == kUs) write_block(block);
+  }
+  writer_.EndArray();
+  writer_.Key("enemyBlocks");
+  writer_.StartArray();
+  for (const auto& block : blocks_) {
+    if (block.owner != kUs) write_block(block);
+  }
+  writer_.EndArray();
+
+  writer_.Key("player");
+  writer_.StartObject();
+  writer_.Key("enemyBlockKills");
+  writer_.Int(me.block_kills);
+  writer_.Key("gameEndedAt");
+  if (ended_) {
+    writer_.String(("turn " + std::to_string(*me.ended_at_turn)).c_str());
+  } else {
+    writer_.Null();
+  }
+  writer_.Key("gold");
+  writer_.Int(me.gold);
+  writer_.Key("name");
+  writer_.String(me.name.c_str());
+  writer_.Key("points");
+  writer_.Int(me.points);
+  writer_.Key("zombieKills");
+  writer_.Int(me.zombie_kills);
+  writer_.EndObject();
+
+  writer_.Key("realmName");
+  writer_.String(name_.c_str());
+  writer_.Key("turn");
+  writer_.Int(turn_);
+  writer_.Key("turnEndsInMs");
+  writer_.Int(0);
+
+  writer_.Key("zombies");
+  writer_.StartArray();
+  for (const auto& zombie : zombies_) {
+    writer_.StartObject();
+    writer_.Key("attack");
+    writer_.Int(zombie.attack);
+    writer_.Key("direction");
+    writer_.String(direction_name(zombie.dir));
+    writer_.Key("health");
+    writer_.Int(zombie.health);
+    writer_.Key("id");
+    writer_.String(zombie.id.c_str());
+    writer_.Key("speed");
+    writer_.Int(zombie.speed);
+    writer_.Key("type");
+    writer_.String(type_name(zombie.type));
+    writer_.Key("waitTurns");
+    writer_.Int(zombie.wait_left);
+    writer_.Key("x");
+    writer_.Int(zombie.pos.x);
+    writer_.Key("y");
+    writer_.Int(zombie.pos.y);
+    writer_.EndObject();
+  }
+  writer_.EndArray();
+  writer_.EndObject();
+  out.assign(buffer_.GetString(), buffer_.GetSize());
+}
+
+}  // namespace mortido::sim
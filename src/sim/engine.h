@@ -0,0 +1,185 @@
+#pragma once
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "api/requests.h"
+#include "models/vec2i.h"
+#include "models/zombie.h"
+
+namespace mortido::sim {
+
+struct ZombieProto {
+  int attack;
+  int health;
+  int speed;
+  int wait_turns;
+  int weight;  // relative spawn frequency
+};
+
+// Everything that shapes a simulated game. The defaults follow what the strategy already
+// assumes about the server (Building defaults, Map spawn probability); numbers the server
+// never told us are rough guesses and meant to be tuned.
+struct Config {
+  uint32_t seed = 1;
+  models::vec2i size{200, 200};
+  int walls = 300;
+  int spawns = 16;
+  int enemies = 3;
+  int max_turns = 450;
+  int start_gold = 20;
+
+  int block_attack = 10;
+  int block_health = 100;
+  int block_range = 8;
+  int head_attack = 40;
+  int head_health = 300;
+  int head_range = 10;
+
+  int zombie_kill_gold = 1;
+  int block_kill_gold = 1;
+  int head_kill_gold = 10;
+  // Zombie health and attack grow by this fraction per turn.
+  double zombie_growth = 0.01;
+
+  // Indexed by models::Zombie::Type.
+  std::array<ZombieProto, 6> zombies{{
+      {.attack = 5, .health = 5, .speed = 1, .wait_turns = 1, .weight = 30},     // normal
+      {.attack = 5, .health = 5, .speed = 2, .wait_turns = 1, .weight = 20},     // fast
+      {.attack = 20, .health = 5, .speed = 1, .wait_turns = 1, .weight = 15},    // bomber
+      {.attack = 10, .health = 5, .speed = 1, .wait_turns = 1, .weight = 15},    // liner
+      {.attack = 999, .health = 30, .speed = 1, .wait_turns = 2, .weight = 5},   // juggernaut
+      {.attack = 10, .health = 15, .speed = 1, .wait_turns = 1, .weight = 15},   // chaos_knight
+  }};
+};
+
+struct PlayerStats {
+  std::string name;
+  int gold = 0;
+  int points = 0;
+  int zombie_kills = 0;
+  int block_kills = 0;
+  bool alive = true;
+  std::optional<int> ended_at_turn;
+};
+
+// Deterministic ZombieDef engine. Player 0 is us and is controlled through step(), the other
+// players are static bases that shoot the nearest target in range. A turn runs:
+//   our base move, attacks (ours, then enemies'), our builds, zombie moves and attacks,
+//   spawns.
+// Zombies move every `wait_turns` turns by `speed` cells and die on walls, spawns and the map
+// edge. On a block normal and fast zombies attack and stay, bombers hit the 3x3 around the
+// block and die, liners hit the whole line of blocks and die, juggernauts crush the block and
+// walk on. Chaos knights jump two cells forward and one to a random side, attacking the block
+// they land on. There is no fog of war: every zombie and enemy block is visible.
+class Engine {
+ public:
+  constexpr static int kUs = 0;
+
+  explicit Engine(const Config& config);
+
+  // Applies our command for the current turn, then advances the world by one turn.
+  void step(const api::Command& command);
+
+  void write_world(std::string& out);
+  // Our `/units` view of the current turn.
+  void write_units(std::string& out);
+
+  [[nodiscard]] int turn() const { return turn_; }
+  [[nodiscard]] bool ended() const { return ended_; }
+  [[nodiscard]] const std::string& name() const { return name_; }
+  [[nodiscard]] const PlayerStats& player(int index) const { return players_.at(index); }
+  [[nodiscard]] size_t block_count(int owner) const;
+  [[nodiscard]] size_t zombie_count() const { return zombies_.size(); }
+  // Whether the per-cell zombie lists hold exactly the live zombie list, each zombie once and on
+  // its own cell. Linear in cells and zombies, for checks between steps.
+  [[nodiscard]] bool zombie_index_valid() const;
+
+ private:
+  enum class CellType : uint8_t { normal, wall, spawn };
+
+  struct Block {
+    std::string id;
+    models::vec2i pos;
+    int owner;
+    int attack;
+    int health;
+    int range;
+    bool is_head;
+    bool attacked;  // already shot this turn
+    std::optional<models::vec2i> last_attack;
+  };
+
+  struct Zombie {
+    std::string id;
+    models::Zombie::Type type;
+    models::vec2i pos;
+    models::vec2i dir;
+    int attack;
+    int health;
+    int speed;
+    int wait_turns;
+    int wait_left;
+  };
+
+  Config config_;
+  std::mt19937 rng_;
+  std::string name_;
+  int turn_ = 0;
+  bool ended_ = false;
+  size_t next_id_ = 0;
+
+  std::vector<CellType> cells_;
+  std::vector<int> block_at_;     // block index per cell, -1 if empty
+  std::vector<int> zombie_head_;  // first zombie per cell, -1 if none
+  std::vector<int> zombie_next_;  // next zombie on the same cell
+  std::vector<models::vec2i> walls_;
+  std::vector<models::vec2i> spawns_;
+  std::vector<Block> blocks_;
+  std::vector<Zombie> zombies_;
+  std::vector<PlayerStats> players_;
+  std::vector<uint8_t> active_;  // ours, connected to the head
+  std::vector<int> bfs_;
+
+  rapidjson::StringBuffer buffer_;
+  rapidjson::Writer<rapidjson::StringBuffer> writer_;
+
+  [[nodiscard]] bool in_bounds(models::vec2i pos) const {
+    return pos.x >= 0 && pos.y >= 0 && pos.x < config_.size.x && pos.y < config_.size.y;
+  }
+  [[nodiscard]] size_t cell(models::vec2i pos) const {
+    return static_cast<size_t>(pos.x) * config_.size.y + pos.y;
+  }
+  [[nodiscard]] bool is_free(models::vec2i pos) const {
+    return in_bounds(pos) && cells_[cell(pos)] == CellType::normal && block_at_[cell(pos)] < 0;
+  }
+  int random(int bound) { return std::uniform_int_distribution<int>(0, bound - 1)(rng_); }
+  std::string make_id(char kind);
+
+  void generate();
+  void add_block(models::vec2i pos, int owner, bool is_head);
+
+  void index_zombies();
+  void mark_active();
+  void move_base(const models::vec2i& target);
+  void attack(Block& block, models::vec2i target);
+  void enemy_attacks();
+  [[nodiscard]] bool can_build(models::vec2i pos) const;
+  void build(models::vec2i pos);
+
+  void move_zombies();
+  bool advance(Zombie& zombie);
+  void jump(Zombie& zombie);
+  void hit(models::vec2i pos, int damage);
+
+  void remove_dead();
+  void spawn_zombies();
+};
+
+}  // namespace mortido::sim
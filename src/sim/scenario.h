@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "models/building.h"
+#include "models/units_reader.h"
+#include "models/vec2i.h"
+#include "models/zombie.h"
+#include "sim/engine.h"
+
+namespace mortido::sim {
+
+// A single synthetic game state with exact entity counts, for stress runs and benchmarks
+// (unlike Engine, which plays a game and gets whatever counts the game produces). Blocks
+// and zombie stats follow Config.
+struct ScenarioConfig {
+  uint32_t seed = 1;
+  int size = 300;
+  size_t spawns = 60;
+  size_t walls = 400;
+  size_t base = 1000;  // own blocks, one connected base around the map center
+  size_t enemy = 5000;  // enemy blocks, in bases of up to enemy_base_size blocks
+  size_t enemy_base_size = 50;
+  // Zombies of each models::Zombie::Type.
+  std::array<size_t, 6> zombies{500, 500, 500, 500, 500, 500};
+  int turn = 300;
+  Config stats;
+
+  void set_zombies(size_t total) {
+    for (size_t i = 0; i < zombies.size(); i++) {
+      zombies[i] = total / zombies.size() + (i < total % zombies.size() ? 1 : 0);
+    }
+  }
+};
+
+struct Scenario {
+  std::vector<models::vec2i> spawns;
+  std::vector<models::vec2i> walls;
+  models::UnitsSnapshot units;
+
+  // The `/world` body for these zpots.
+  [[nodiscard]] std::string world_json() const {
+    std::string json = "{\"realmName\":\"stress\",\"zpots\":[";
+    auto append = [&](models::vec2i pos, const char* type) {
+      if (json.back() == '}') json += ',';
+      json += "{\"x\":" + std::to_string(pos.x) + ",\"y\":" + std::to_string(pos.y) +
+              ",\"type\":\"" + type + "\"}";
+    };
+    for (auto pos : spawns) append(pos, "default");
+    for (auto pos : walls) append(pos, "wall");
+    json += "]}";
+    return json;
+  }
+};
+
+class ScenarioGenerator {
+ public:
+  explicit ScenarioGenerator(const ScenarioConfig& config)
+      : config_(config), rng_(config.seed), coord_(0, config.size - 1) {}
+
+  Scenario generate() {
+    Scenario scenario;
+    std::unordered_set<models::vec2i> taken;
+    auto& units = scenario.units;
+    units.turn = config_.turn;
+    units.turn_ends_in_ms = 1000;
+    units.player.name = kOwnName;
+    units.player.gold = static_cast<int>(config_.base / 4) + config_.stats.start_gold;
+
+    // The own base first, so its center is never taken.
+    auto own = grow_blob({config_.size / 2, config_.size / 2}, config_.base, taken);
+    for (size_t i = 0; i < own.size(); i++) {
+      units.base.push_back(make_block(own[i], i == 0, false, kOwnName));
+    }
+    place(config_.spawns, scenario.spawns, taken);
+    place(config_.walls, scenario.walls, taken);
+
+    // A bounded number of tries: blobs may come out empty on crowded maps.
+    for (size_t placed = 0, base = 0; placed < config_.enemy && base < config_.enemy; base++) {
+      auto blob = grow_blob(random_pos(), std::min(config_.enemy_base_size, config_.enemy - placed),
+                            taken);
+      auto owner = "enemy-" + std::to_string(base);
+      for (size_t i = 0; i < blob.size(); i++) {
+        units.enemy_blocks.push_back(make_block(blob[i], i == 0, true, owner));
+      }
+      placed += blob.size();
+    }
+
+    for (size_t type = 0; type < config_.zombies.size(); type++) {
+      for (size_t i = 0; i < config_.zombies[type]; i++) {
+        units.zombies.push_back(make_zombie(static_cast<models::Zombie::Type>(type)));
+      }
+    }
+    std::shuffle(units.zombies.begin(), units.zombies.end(), rng_);
+    return scenario;
+  }
+
+  // Moves the state one turn on: zombies step (turning back at the map edge), blocks report
+  // new attacks, the turn advances. Counts stay the same, ids are kept.
+  void advance(Scenario& scenario) {
+    auto& units = scenario.units;
+    units.turn = units.turn.value_or(0) + 1;
+    for (auto& zombie : units.zombies) {
+      if (zombie.wait_turns > 1) {
+        zombie.wait_turns--;
+        continue;
+      }
+      zombie.wait_turns = config_.stats.zombies[static_cast<size_t>(zombie.type)].wait_turns;
+      for (int step = 0; step < zombie.speed; step++) {
+        auto next = zombie.position + zombie.direction;
+        if (next.x < 0 || next.y < 0 || next.x >= config_.size || next.y >= config_.size) {
+          zombie.direction.mul(-1);
+          next = zombie.position + zombie.direction;
+        }
+        zombie.position = next;
+      }
+    }
+    for (auto* blocks : {&units.base, &units.enemy_blocks}) {
+      for (auto& block : *blocks) {
+        block.last_attack = attack_target(block);
+      }
+    }
+  }
+
+ private:
+  constexpr static const char* kOwnName = "mortido";
+
+  ScenarioConfig config_;
+  std::mt19937 rng_;
+  std::uniform_int_distribution<int> coord_;
+
+  models::vec2i random_pos() { return {coord_(rng_), coord_(rng_)}; }
+
+  void place(size_t count, std::vector<models::vec2i>& out,
+             std::unordered_set<models::vec2i>& taken) {
+    // Retries taken cells, within a bound for maps too small to fit `count`.
+    for (size_t placed = 0, tries = 0; placed < count && tries < count * 16; tries++) {
+      auto pos = random_pos();
+      if (taken.insert(pos).second) {
+        out.push_back(pos);
+        placed++;
+      }
+    }
+  }
+
+  // A connected blob grown from `center` in random order; the center comes first.
+  std::vector<models::vec2i> grow_blob(models::vec2i center, size_t count,
+                                       std::unordered_set<models::vec2i>& taken) {
+    static const models::vec2i kDirections[] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+    std::vector<models::vec2i> blob;
+    std::vector<models::vec2i> frontier = {center};
+    while (blob.size() < count && !frontier.empty()) {
+      size_t pick = std::uniform_int_distribution<size_t>(0, frontier.size() - 1)(rng_);
+      auto pos = frontier[pick];
+      frontier[pick] = frontier.back();
+      frontier.pop_back();
+      if (pos.x < 0 || pos.y < 0 || pos.x >= config_.size || pos.y >= config_.size ||
+          !taken.insert(pos).second) {
+        continue;
+      }
+      blob.push_back(pos);
+      for (auto dir : kDirections) {
+        frontier.push_back(pos + dir);
+      }
+    }
+    return blob;
+  }
+
+  // Shaped like the server's uuids, so string copies cost what they do in a real game.
+  std::string make_id() {
+    char id[37];
+    std::snprintf(id, sizeof(id), "%08x-%04x-%04x-%04x-%08x%04x", static_cast<unsigned>(rng_()),
+                  static_cast<unsigned>(rng_() & 0xffff), static_cast<unsigned>(rng_() & 0xffff),
+                  static_cast<unsigned>(rng_() & 0xffff), static_cast<unsigned>(rng_()),
+                  static_cast<unsigned>(rng_() & 0xffff));
+    return id;
+  }
+
+  std::optional<models::vec2i> attack_target(const models::Building& block) {
+    if (rng_() % 2 == 0) {
+      return std::nullopt;
+    }
+    std::uniform_int_distribution<int> offset(-block.range / 2, block.range / 2);
+    return block.position + models::vec2i{offset(rng_), offset(rng_)};
+  }
+
+  models::Building make_block(models::vec2i pos, bool is_head, bool is_enemy,
+                              const std::string& owner) {
+    const auto& stats = config_.stats;
+    models::Building block;
+    block.is_head = is_head;
+    block.is_enemy = is_enemy;
+    block.attack = is_head ? stats.head_attack : stats.block_attack;
+    block.health =
+        std::uniform_int_distribution<int>(1, is_head ? stats.head_health : stats.block_health)(
+            rng_);
+    block.range = is_head ? stats.head_range : stats.block_range;
+    block.player_name = owner;
+    block.id = make_id();
+    block.position = pos;
+    block.last_attack = attack_target(block);
+    return block;
+  }
+
+  models::Zombie make_zombie(models::Zombie::Type type) {
+    static const models::vec2i kDirections[] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+    const auto& proto = config_.stats.zombies[static_cast<size_t>(type)];
+    models::Zombie zombie{};
+    zombie.type = type;
+    zombie.attack = proto.attack;
+    zombie.health = std::uniform_int_distribution<int>(1, proto.health)(rng_);
+    zombie.wait_turns = std::uniform_int_distribution<int>(1, proto.wait_turns)(rng_);
+    zombie.speed = proto.speed;
+    zombie.direction = kDirections[rng_() % 4];
+    zombie.id = make_id();
+    zombie.position = random_pos();
+    return zombie;
+  }
+};
+
+}  // namespace mortido::sim
@@ -0,0 +1,186 @@
+#pragma once
+
+// Chrome trace-event timeline of the game loop (load the output in chrome://tracing or
+// https://ui.perfetto.dev). Only compiled with -DTRACE (CMake option TRACE); otherwise the
+// TRACE_* macros expand to nothing. PERF_SCOPE phases are traced as well.
+
+#ifdef TRACE
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace mortido::trace {
+
+struct Event {
+  constexpr static size_t kMaxDetail = 46;
+
+  const char* name;  // static strings only
+  int64_t start_ns;
+  int64_t duration_ns;  // -1 for instant events
+  uint8_t detail_size;
+  char detail[kMaxDetail];  // truncated copy, e.g. the request handle
+};
+
+// Events go to a buffer owned by the recording thread: record() takes no lock and does not
+// allocate, except for a new chunk every kChunkSize events. clear() and write() are called
+// from one control thread; write() only reads what was published before it started.
+class Tracer {
+ public:
+  static Tracer& instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  [[nodiscard]] int64_t now_ns() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch_)
+        .count();
+  }
+
+  void record(const char* name, std::string_view detail, int64_t start_ns, int64_t duration_ns) {
+    auto& buffer = thread_buffer();
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (buffer.generation.load(std::memory_order_relaxed) != generation) {
+      // First event since clear(): start over in the chunks already allocated
+      buffer.count.store(0, std::memory_order_relaxed);
+      buffer.generation.store(generation, std::memory_order_release);
+    }
+    size_t i = buffer.count.load(std::memory_order_relaxed);
+    size_t chunk = i / kChunkSize;
+    if (chunk >= kMaxChunks) {
+      return;  // full until the next clear()
+    }
+    if (!buffer.chunks[chunk]) {
+      buffer.chunks[chunk] = std::make_unique<Event[]>(kChunkSize);
+    }
+    auto& event = buffer.chunks[chunk][i % kChunkSize];
+    event.name = name;
+    event.start_ns = start_ns;
+    event.duration_ns = duration_ns;
+    event.detail_size = static_cast<uint8_t>(std::min(detail.size(), Event::kMaxDetail));
+    std::memcpy(event.detail, detail.data(), event.detail_size);
+    buffer.count.store(i + 1, std::memory_order_release);
+  }
+
+  // Drops everything recorded so far, e.g. at the start of a game.
+  void clear() { generation_.fetch_add(1, std::memory_order_acq_rel); }
+
+  // Writes the events recorded so far as a trace-event JSON file.
+  bool write(const std::filesystem::path& path) {
+    std::FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) {
+      return false;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    std::lock_guard lock(mutex_);
+    for (auto& buffer : buffers_) {
+      if (buffer->generation.load(std::memory_order_acquire) != generation) {
+        continue;  // nothing recorded since clear()
+      }
+      size_t count = buffer->count.load(std::memory_order_acquire);
+      for (size_t i = 0; i < count; i++) {
+        const auto& event = buffer->chunks[i / kChunkSize][i % kChunkSize];
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                     first ? "" : ",\n", event.name, event.duration_ns < 0 ? "i" : "X",
+                     buffer->id, static_cast<double>(event.start_ns) / 1e3);
+        if (event.duration_ns >= 0) {
+          std::fprintf(file, ",\"dur\":%.3f", static_cast<double>(event.duration_ns) / 1e3);
+        } else {
+          std::fputs(",\"s\":\"t\"", file);
+        }
+        if (event.detail_size > 0) {
+          std::fputs(",\"args\":{\"detail\":\"", file);
+          for (char c : std::string_view(event.detail, event.detail_size)) {
+            if (c == '"' || c == '\\') std::fputc('\\', file);
+            std::fputc(static_cast<unsigned char>(c) < 0x20 ? ' ' : c, file);
+          }
+          std::fputs("\"}", file);
+        }
+        std::fputc('}', file);
+        first = false;
+      }
+    }
+    std::fputs("\n]}\n", file);
+    std::fclose(file);
+    return true;
+  }
+
+ private:
+  constexpr static size_t kChunkSize = 1024;
+  constexpr static size_t kMaxChunks = 1024;  // ~1M events per thread between clear() calls
+
+  struct ThreadBuffer {
+    int id = 0;
+    std::atomic<uint64_t> generation{0};
+    std::atomic<size_t> count{0};  // events published in this generation
+    std::array<std::unique_ptr<Event[]>, kMaxChunks> chunks;
+  };
+
+  std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+  std::atomic<uint64_t> generation_{0};
+  std::mutex mutex_;  // guards buffers_, taken once per thread and by write()
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+  ThreadBuffer& thread_buffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [this] {
+      auto created = std::make_shared<ThreadBuffer>();
+      std::lock_guard lock(mutex_);
+      created->id = static_cast<int>(buffers_.size()) + 1;
+      created->generation.store(generation_.load(std::memory_order_acquire));
+      buffers_.push_back(created);
+      return created;
+    }();
+    return *buffer;
+  }
+};
+
+class Span {
+ public:
+  explicit Span(const char* name, std::string_view detail = {})
+      : name_(name), detail_(detail), start_ns_(Tracer::instance().now_ns()) {}
+  ~Span() {
+    auto& tracer = Tracer::instance();
+    tracer.record(name_, detail_, start_ns_, tracer.now_ns() - start_ns_);
+  }
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+ private:
+  const char* name_;
+  std::string_view detail_;
+  int64_t start_ns_;
+};
+
+inline void instant(const char* name, std::string_view detail = {}) {
+  auto& tracer = Tracer::instance();
+  tracer.record(name, detail, tracer.now_ns(), -1);
+}
+
+}  // namespace mortido::trace
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+// Span over the rest of the enclosing scope. `detail` must outlive the scope.
+#define TRACE_SCOPE(name, ...) \
+  ::mortido::trace::Span TRACE_CONCAT(trace_span_, __LINE__)(name, ##__VA_ARGS__)
+#define TRACE_INSTANT(name, ...) ::mortido::trace::instant(name, ##__VA_ARGS__)
+
+#else
+
+#define TRACE_SCOPE(name, ...)
+#define TRACE_INSTANT(name, ...)
+
+#endif
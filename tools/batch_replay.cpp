@@ -0,0 +1,173 @@
+// Replays many dump_v2 or delta (.dlt) files in parallel through the decision pipeline (see
+// replay_runner.h) and aggregates per-game and overall metrics: decision counts, per-turn
+// compute time percentiles and predicted kills. Each worker thread replays whole games with its
+// own State.
+//
+// usage: mortido-batch-replay [-j <threads>] [--quiet] <dir | file | 'glob'>...
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "dump_files.h"
+#include "logger.h"
+#include "replay_runner.h"
+#include "task_pool.h"
+
+namespace {
+
+using mortido::tools::TurnResult;
+
+struct GameMetrics {
+  bool ok = false;
+  std::string error;
+  size_t turns = 0;
+  size_t attacks = 0;
+  size_t builds = 0;
+  size_t base_moves = 0;
+  int64_t predicted_kills = 0;
+  std::vector<int64_t> turn_ns;
+
+  void add(const GameMetrics& other) {
+    turns += other.turns;
+    attacks += other.attacks;
+    builds += other.builds;
+    base_moves += other.base_moves;
+    predicted_kills += other.predicted_kills;
+    turn_ns.insert(turn_ns.end(), other.turn_ns.begin(), other.turn_ns.end());
+  }
+};
+
+// Nearest-rank percentile, `sorted` has to be sorted.
+double percentile_us(const std::vector<int64_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+  return static_cast<double>(sorted[std::min(rank, sorted.size() - 1)]) / 1000.0;
+}
+
+GameMetrics replay(const std::filesystem::path& file) {
+  GameMetrics metrics;
+  try {
+    mortido::tools::ReplayRunner runner(file);
+    auto turns = runner.run([&](const TurnResult& result, const mortido::models::State&) {
+      metrics.attacks += result.command.attack.size();
+      metrics.builds += result.command.build.size();
+      metrics.base_moves += result.command.move_base.has_value();
+      metrics.predicted_kills += result.predicted_kills;
+      metrics.turn_ns.push_back(result.total_ns());
+    });
+    if (turns) {
+      metrics.ok = true;
+      metrics.turns = *turns;
+    } else {
+      metrics.error = "no world/units to replay";
+    }
+  } catch (const std::exception& e) {
+    metrics.error = e.what();
+  }
+  std::sort(metrics.turn_ns.begin(), metrics.turn_ns.end());
+  return metrics;
+}
+
+void print_header() {
+  std::printf("%-40s %6s %8s %8s %6s %8s %9s %9s %9s %9s\n", "game", "turns", "attacks",
+              "builds", "moves", "kills", "p50_us", "p90_us", "p99_us", "max_us");
+}
+
+void print_row(const std::string& name, const GameMetrics& metrics) {
+  const auto& ns = metrics.turn_ns;
+  std::printf("%-40s %6zu %8zu %8zu %6zu %8lld %9.1f %9.1f %9.1f %9.1f\n", name.c_str(),
+              metrics.turns, metrics.attacks, metrics.builds, metrics.base_moves,
+              static_cast<long long>(metrics.predicted_kills), percentile_us(ns, 50),
+              percentile_us(ns, 90), percentile_us(ns, 99), ns.empty() ? 0.0 : ns.back() / 1000.0);
+}
+
+void print_usage(const char* name) {
+  std::fprintf(stderr, "usage: %s [-j <threads>] [--quiet] <dir | file | 'glob'>...\n", name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t threads = mortido::tools::default_threads();
+  bool quiet = false;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else if (argv[i][0] != '-') {
+      inputs.emplace_back(argv[i]);
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  auto files = mortido::tools::collect_dump_files(inputs);
+  if (files.empty()) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+
+  // Smallest dumps first in every deque: workers take from the back, so the long games start
+  // early and stealing evens out the tail.
+  std::vector<size_t> order(files.size());
+  std::vector<uintmax_t> sizes(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    std::error_code ec;
+    order[i] = i;
+    sizes[i] = std::filesystem::file_size(files[i], ec);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&](size_t a, size_t b) { return sizes[a] < sizes[b]; });
+
+  std::vector<GameMetrics> games(files.size());
+  auto start = std::chrono::steady_clock::now();
+  mortido::tools::parallel_for(files.size(), threads, [&](size_t, size_t i) {
+    games[order[i]] = replay(files[order[i]]);
+  });
+  double wall_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  GameMetrics total;
+  size_t failed = 0;
+  if (!quiet) {
+    print_header();
+  }
+  for (size_t i = 0; i < files.size(); i++) {
+    const auto& game = games[i];
+    if (!game.ok) {
+      std::fprintf(stderr, "%s: %s\n", files[i].c_str(), game.error.c_str());
+      failed++;
+      continue;
+    }
+    total.add(game);
+    if (!quiet) {
+      print_row(files[i].filename().string(), game);
+    }
+  }
+  std::sort(total.turn_ns.begin(), total.turn_ns.end());
+  if (!quiet) {
+    std::printf("\n");
+    print_header();
+  }
+  print_row("TOTAL", total);
+
+  std::printf("\n%zu games (%zu failed), %zu turns on %zu threads in %.1f ms: %.1f games/s, "
+              "%.0f turns/s\n",
+              files.size(), failed, total.turns, std::min(threads, files.size()), wall_ms,
+              static_cast<double>(files.size()) / wall_ms * 1000.0,
+              static_cast<double>(total.turns) / wall_ms * 1000.0);
+  return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
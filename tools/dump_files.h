@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <glob.h>
+#endif
+
+namespace mortido::tools {
+
+// Expands command line arguments to dump files: a directory stands for every `*.dump` and
+// `*.dlt` (delta dump, see api/delta_file.h) in it, a pattern is expanded with glob(3) (for
+// quoted patterns the shell did not expand), anything else is taken as a file. The result is
+// sorted and without duplicates.
+inline std::vector<std::filesystem::path> collect_dump_files(const std::vector<std::string>& args) {
+  std::vector<std::filesystem::path> files;
+  for (const auto& arg : args) {
+    std::error_code ec;
+    if (std::filesystem::is_directory(arg, ec)) {
+      for (const auto& entry : std::filesystem::directory_iterator(arg, ec)) {
+        if (entry.is_regular_file() &&
+            (entry.path().extension() == ".dump" || entry.path().extension() == ".dlt")) {
+          files.push_back(entry.path());
+        }
+      }
+      continue;
+    }
+#ifndef _WIN32
+    if (arg.find_first_of("*?[") != std::string::npos) {
+      glob_t matches{};
+      if (::glob(arg.c_str(), 0, nullptr, &matches) == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; i++) {
+          files.emplace_back(matches.gl_pathv[i]);
+        }
+      }
+      ::globfree(&matches);
+      continue;
+    }
+#endif
+    files.emplace_back(arg);
+  }
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+  return files;
+}
+
+}  // namespace mortido::tools
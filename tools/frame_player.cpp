@@ -0,0 +1,141 @@
+// Streams viewer frames recorded by a DRAW build run with MORTIDO_RECORD_FRAMES=1
+// (data/<round>.frames, api/frame_file.h) to a running rewind_viewer, as if the bot were drawing
+// live: the recorded schema version first, then every frame's messages unchanged. --from/--to
+// pick a range of frames (turns), --fps paces them; by default they are sent as fast as the
+// viewer reads them.
+//
+// usage: mortido-frame-player [--host <host>] [--port <port>] [--from <n>] [--to <n>]
+//            [--fps <n>] <file.frames>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "api/frame_file.h"
+#include "clsocket/ActiveSocket.h"
+#include "logger.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [--host <host>] [--port <port>] [--from <n>] [--to <n>] [--fps <n>] "
+               "<file.frames>\n",
+               name);
+}
+
+bool send_all(CActiveSocket& socket, const void* data, size_t size) {
+  auto* bytes = static_cast<const uint8*>(data);
+  while (size > 0) {
+    int32 sent = socket.Send(bytes, size);
+    if (sent <= 0) {
+      return false;
+    }
+    bytes += sent;
+    size -= static_cast<size_t>(sent);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string host = "127.0.0.1";
+  uint16 port = 9111;
+  size_t from = 0;
+  size_t to = SIZE_MAX;
+  double fps = 0.0;
+  const char* input = nullptr;
+  for (int i = 1; i < argc; i++) {
+    auto arg = std::string_view(argv[i]);
+    if (arg.substr(0, 2) != "--") {
+      input = argv[i];
+      continue;
+    }
+    if (i + 1 >= argc) {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    const char* value = argv[++i];
+    if (arg == "--host") {
+      host = value;
+    } else if (arg == "--port") {
+      port = static_cast<uint16>(std::atoi(value));
+    } else if (arg == "--from") {
+      from = std::strtoul(value, nullptr, 10);
+    } else if (arg == "--to") {
+      to = std::strtoul(value, nullptr, 10);
+    } else if (arg == "--fps") {
+      fps = std::atof(value);
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (!input) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  loguru::init(argc, argv);
+
+  try {
+    mortido::api::FrameReader reader(input);
+    to = std::min(to, reader.frames());
+    LOG_INFO("%s: %zu frames, schema %d", input, reader.frames(), reader.schema_version());
+
+    CActiveSocket socket;
+    if (!socket.Initialize() || !socket.Open(host.c_str(), port)) {
+      LOG_ERROR("Could not connect to the viewer at %s:%u: %s", host.c_str(), port,
+                socket.DescribeError());
+      return EXIT_FAILURE;
+    }
+    socket.DisableNagleAlgoritm();
+    uint16_t schema_version = reader.schema_version();
+    if (!send_all(socket, &schema_version, sizeof(schema_version))) {
+      LOG_ERROR("Viewer closed the connection: %s", socket.DescribeError());
+      return EXIT_FAILURE;
+    }
+
+    auto period = fps > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                  std::chrono::duration<double>(1.0 / fps))
+                            : Clock::duration::zero();
+    auto started = Clock::now();
+    auto next = started;
+    std::string frame;
+    size_t sent = 0;
+    size_t bytes = 0;
+    size_t corrupted = 0;
+    for (size_t i = from; i < to; i++) {
+      if (!reader.frame(i, frame)) {
+        corrupted++;
+        continue;
+      }
+      if (period != Clock::duration::zero()) {
+        std::this_thread::sleep_until(next);
+        next += period;
+      }
+      if (!send_all(socket, frame.data(), frame.size())) {
+        LOG_ERROR("Viewer closed the connection at frame %zu: %s", i, socket.DescribeError());
+        break;
+      }
+      sent++;
+      bytes += frame.size();
+    }
+    socket.Close();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    LOG_INFO("Sent %zu frames (%.1f MB) in %.1fs, %zu corrupted", sent,
+             static_cast<double>(bytes) / 1e6, seconds, corrupted);
+    return sent + corrupted == to - std::min(from, to) ? EXIT_SUCCESS : EXIT_FAILURE;
+  } catch (const std::exception& e) {
+    LOG_ERROR("%s", e.what());
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,351 @@
+// Loopback stand-in for the game server: serves /rounds/zombidef/, participate, /world, /units
+// and /command from a dump_v2 replay or the local simulator, so HttpApi can be run end to end
+// offline. Every request can be delayed (latency + uniform jitter), answered with 429 or left
+// hanging until the client gives up, to exercise the retry loop and the rate limiter.
+// The server handles one connection at a time, like the bot's client, and exits once the game
+// is over and the final /units has been served.
+//
+// usage: mortido-mock-server [--port <port>] [--dump <file> | --sim <seed>]
+//            [--latency-ms <ms>] [--jitter-ms <ms>] [--429 <probability>] [--max-rps <rps>]
+//            [--timeout <probability>] [--timeout-ms <ms>]
+//
+// Point the bot at it with MORTIDO_SERVER_URL=http://127.0.0.1:<port>.
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "api/command_reader.h"
+#include "api/dump_v2.h"
+#include "api/sim.h"
+#include "clsocket/PassiveSocket.h"
+#include "logger.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Faults {
+  int latency_ms = 0;
+  int jitter_ms = 0;
+  double error_429 = 0.0;  // probability of a spurious 429
+  size_t max_rps = 0;      // 0: no limit
+  double timeout = 0.0;    // probability of never answering
+  int timeout_ms = 5000;   // how long a hanging request holds the connection
+};
+
+struct HttpRequest {
+  std::string method;
+  std::string path;
+  std::string body;
+};
+
+struct RouteStats {
+  size_t requests = 0;
+  size_t ok = 0;
+  size_t rejected = 0;  // 429
+  size_t timeouts = 0;
+  int64_t handle_ns = 0;
+};
+
+std::string format_time(std::chrono::system_clock::time_point time) {
+  std::time_t t = std::chrono::system_clock::to_time_t(time);
+  std::tm local_tm = *std::localtime(&t);
+  std::ostringstream oss;
+  oss << std::put_time(&local_tm, "%Y-%m-%dT%H:%M:%S");
+  return oss.str();
+}
+
+// RFC 7231 Date header value, which HttpApi uses to measure the server clock offset.
+std::string format_http_date(std::chrono::system_clock::time_point time) {
+  std::time_t t = std::chrono::system_clock::to_time_t(time);
+  std::tm utc_tm = *std::gmtime(&t);
+  char buffer[64];
+  size_t size = std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", &utc_tm);
+  return std::string(buffer, size);
+}
+
+// Reads one request: headers up to the blank line, then Content-Length bytes of body.
+bool read_request(CActiveSocket& client, HttpRequest& request) {
+  std::string data;
+  uint8 buffer[16 * 1024];
+  size_t header_end = std::string::npos;
+  size_t content_length = 0;
+  while (header_end == std::string::npos || data.size() < header_end + 4 + content_length) {
+    int32 received = client.Receive(sizeof(buffer), buffer);
+    if (received <= 0) {
+      return false;
+    }
+    data.append(reinterpret_cast<const char*>(buffer), received);
+    if (header_end != std::string::npos) {
+      continue;
+    }
+    header_end = data.find("\r\n\r\n");
+    if (header_end != std::string::npos) {
+      std::string headers = data.substr(0, header_end);
+      for (auto& c : headers) c = static_cast<char>(std::tolower(c));
+      size_t pos = headers.find("\r\ncontent-length:");
+      if (pos != std::string::npos) {
+        content_length = std::strtoul(headers.c_str() + pos + 17, nullptr, 10);
+      }
+    }
+  }
+
+  std::istringstream request_line(data.substr(0, data.find("\r\n")));
+  request_line >> request.method >> request.path;
+  request.path = request.path.substr(0, request.path.find('?'));
+  request.body = data.substr(header_end + 4, content_length);
+  return !request.method.empty();
+}
+
+void send_response(CActiveSocket& client, int code, std::string_view body) {
+  const char* reason = code == 200 ? "OK" : code == 429 ? "Too Many Requests" : "Error";
+  std::string response = "HTTP/1.1 " + std::to_string(code) + " " + reason +
+                         "\r\nDate: " + format_http_date(std::chrono::system_clock::now()) +
+                         "\r\nContent-Type: application/json\r\nContent-Length: " +
+                         std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+  response.append(body);
+  client.Send(reinterpret_cast<const uint8*>(response.data()), response.size());
+}
+
+std::string error_body(int code, const std::string& message) {
+  return R"({"errCode":)" + std::to_string(code) + R"(,"error":")" + message + "\"}";
+}
+
+class MockServer {
+ public:
+  MockServer(mortido::api::Api& backend, const Faults& faults)
+      : backend_(backend), faults_(faults), rng_(std::random_device{}()) {}
+
+  // Serves until the game is over. Returns false if the socket could not be opened.
+  bool serve(uint16 port) {
+    CPassiveSocket socket;
+    if (!socket.Initialize() || !socket.Listen("127.0.0.1", port)) {
+      LOG_ERROR("Could not listen on 127.0.0.1:%u: %s", port, socket.DescribeError());
+      return false;
+    }
+    LOG_INFO("Serving %s on http://127.0.0.1:%u", round_name_.c_str(), port);
+
+    while (!finished_) {
+      std::unique_ptr<CActiveSocket> client(socket.Accept());
+      if (!client) {
+        continue;
+      }
+      HttpRequest request;
+      if (read_request(*client, request)) {
+        handle(*client, request);
+      }
+      client->Close();
+    }
+    return true;
+  }
+
+  void print_stats() const {
+    std::printf("%-28s %9s %8s %8s %9s %12s\n", "route", "requests", "ok", "429", "timeouts",
+                "handle_us");
+    for (const auto& [route, stats] : stats_) {
+      std::printf("%-28s %9zu %8zu %8zu %9zu %12.1f\n", route.c_str(), stats.requests, stats.ok,
+                  stats.rejected, stats.timeouts,
+                  stats.ok > 0 ? static_cast<double>(stats.handle_ns) / 1e3 / stats.ok : 0.0);
+    }
+  }
+
+  void set_round_name(std::string name) { round_name_ = std::move(name); }
+
+ private:
+  mortido::api::Api& backend_;
+  Faults faults_;
+  std::mt19937 rng_;
+  std::string round_name_;
+  std::map<std::string, RouteStats> stats_;
+  std::deque<Clock::time_point> recent_;  // accepted requests within the last second
+  mortido::api::CommandReader command_reader_;
+  rapidjson::StringBuffer buffer_;
+  bool finished_ = false;
+
+  bool chance(double probability) {
+    return probability > 0.0 &&
+           std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < probability;
+  }
+
+  bool over_rate_limit() {
+    if (faults_.max_rps == 0) {
+      return false;
+    }
+    auto now = Clock::now();
+    while (!recent_.empty() && now - recent_.front() >= std::chrono::seconds(1)) {
+      recent_.pop_front();
+    }
+    if (recent_.size() >= faults_.max_rps) {
+      return true;
+    }
+    recent_.push_back(now);
+    return false;
+  }
+
+  void handle(CActiveSocket& client, const HttpRequest& request) {
+    auto& stats = stats_[request.method + " " + request.path];
+    stats.requests++;
+
+    if (chance(faults_.timeout)) {
+      LOG_DEBUG("%s %s: hanging for %d ms", request.method.c_str(), request.path.c_str(),
+                faults_.timeout_ms);
+      stats.timeouts++;
+      std::this_thread::sleep_for(std::chrono::milliseconds(faults_.timeout_ms));
+      return;
+    }
+    if (over_rate_limit() || chance(faults_.error_429)) {
+      stats.rejected++;
+      send_response(client, 429, error_body(429, "too many requests"));
+      return;
+    }
+
+    auto start = Clock::now();
+    std::string body;
+    int code = route(request, body);
+    stats.handle_ns +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    stats.ok++;
+
+    int delay_ms = faults_.latency_ms;
+    if (faults_.jitter_ms > 0) {
+      delay_ms += std::uniform_int_distribution<int>(0, faults_.jitter_ms)(rng_);
+    }
+    if (delay_ms > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    }
+    send_response(client, code, body);
+  }
+
+  int route(const HttpRequest& request, std::string& body) {
+    const auto& path = request.path;
+    if (path == "/rounds/zombidef/" || path == "/rounds/zombidef") {
+      body = rounds_json();
+    } else if (path == "/play/zombidef/participate") {
+      body = R"({"startsInSec":0})";
+    } else if (path == "/play/zombidef/world") {
+      body = to_json(backend_.get_world());
+    } else if (path == "/play/zombidef/units") {
+      body = backend_.get_units_json();
+      finished_ = !backend_.active();
+    } else if (path == "/play/zombidef/command" && request.method == "POST") {
+      auto command = command_reader_.decode(request.body);
+      if (!command) {
+        body = error_body(400, "invalid command");
+        return 400;
+      }
+      backend_.send_command(*command);
+      body = R"({"acceptedCommands":)" + request.body + R"(,"errors":[]})";
+    } else {
+      body = error_body(404, "unknown handle " + path);
+      return 404;
+    }
+    return 200;
+  }
+
+  std::string rounds_json() const {
+    auto now = std::chrono::system_clock::now();
+    auto time = format_time(now);
+    std::string status = finished_ ? "ended" : "active";
+    return R"({"gameName":"zombidef","now":")" + time + R"(","rounds":[{"duration":3600,)" +
+           R"("endAt":")" + format_time(now + std::chrono::hours(1)) + R"(","name":")" +
+           round_name_ + R"(","startAt":")" + time + R"(","status":")" + status + R"("}]})";
+  }
+
+  std::string to_json(const mortido::api::JsonDocument& document) {
+    buffer_.Clear();
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer_);
+    document.Accept(writer);
+    return {buffer_.GetString(), buffer_.GetSize()};
+  }
+};
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [--port <port>] [--dump <file> | --sim <seed>] [--latency-ms <ms>] "
+               "[--jitter-ms <ms>] [--429 <probability>] [--max-rps <rps>] "
+               "[--timeout <probability>] [--timeout-ms <ms>]\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  uint16 port = 8080;
+  std::optional<std::string> dump_file;
+  mortido::sim::Config sim_config;
+  Faults faults;
+  for (int i = 1; i < argc; i++) {
+    auto arg = std::string_view(argv[i]);
+    if (i + 1 >= argc) {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    const char* value = argv[++i];
+    if (arg == "--port") {
+      port = static_cast<uint16>(std::atoi(value));
+    } else if (arg == "--dump") {
+      dump_file = value;
+    } else if (arg == "--sim") {
+      sim_config.seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    } else if (arg == "--latency-ms") {
+      faults.latency_ms = std::atoi(value);
+    } else if (arg == "--jitter-ms") {
+      faults.jitter_ms = std::atoi(value);
+    } else if (arg == "--429") {
+      faults.error_429 = std::atof(value);
+    } else if (arg == "--max-rps") {
+      faults.max_rps = std::strtoul(value, nullptr, 10);
+    } else if (arg == "--timeout") {
+      faults.timeout = std::atof(value);
+    } else if (arg == "--timeout-ms") {
+      faults.timeout_ms = std::atoi(value);
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  loguru::init(argc, argv);
+
+  std::unique_ptr<mortido::api::Api> backend;
+  std::string round_name;
+  try {
+    if (dump_file) {
+      backend = std::make_unique<mortido::api::DumpApi>(*dump_file);
+      round_name = "mock-" + std::filesystem::path(*dump_file).stem().string();
+    } else {
+      auto sim = std::make_unique<mortido::api::SimApi>(sim_config);
+      round_name = "mock-" + sim->engine().name();
+      backend = std::move(sim);
+    }
+  } catch (const std::exception& e) {
+    LOG_ERROR("%s", e.what());
+    return EXIT_FAILURE;
+  }
+
+  MockServer server(*backend, faults);
+  server.set_round_name(round_name);
+  if (!server.serve(port)) {
+    return EXIT_FAILURE;
+  }
+  server.print_stats();
+  return EXIT_SUCCESS;
+}
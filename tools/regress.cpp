@@ -0,0 +1,268 @@
+// Decision regression check: replays dump_v2 and delta (.dlt) files in parallel and compares
+// the Command the current build computes for every turn with the `/command` body recorded after
+// that turn's `/units`. Attacks (block id + target) and builds are compared as sets, the base
+// move as a value. Exits with 1 if any turn diverges, or if a game has no recorded command to
+// compare (e.g. a pre-v2 or generated dump), so a Map/State refactor can be checked against a
+// corpus of dumps.
+//
+// usage: mortido-regress [-j <threads>] [--verbose] [--max-diffs <n>] <dir | file | 'glob'>...
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "api/command_reader.h"
+#include "api/delta_file.h"
+#include "api/dump_scanner.h"
+#include "api/mapped_file.h"
+#include "dump_files.h"
+#include "logger.h"
+#include "replay_runner.h"
+#include "task_pool.h"
+
+namespace {
+
+using mortido::api::Command;
+using mortido::models::vec2i;
+using mortido::tools::TurnResult;
+
+struct TurnDiff {
+  int turn = 0;
+  std::vector<std::string> lines;  // "-" recorded only, "+" computed only
+};
+
+struct GameReport {
+  bool ok = false;
+  std::string error;
+  size_t turns = 0;
+  size_t compared = 0;  // turns with a recorded command
+  size_t attack_diffs = 0;
+  size_t build_diffs = 0;
+  size_t move_diffs = 0;
+  std::vector<TurnDiff> diffs;
+
+  [[nodiscard]] size_t diverged() const { return diffs.size(); }
+};
+
+// Recorded `/command` bodies keyed by the turn of the last `/units` before them. The first
+// command after a `/units` wins: that is the one decided from it.
+std::unordered_map<int, std::string> recorded_commands(std::string_view dump) {
+  std::unordered_map<int, std::string> commands;
+  mortido::api::DumpScanner scanner(dump);
+  mortido::api::DumpSegment segment;
+  std::optional<int> units_turn;
+  while (scanner.next(segment)) {
+    if (segment.handle == mortido::api::kUnitsHandle && segment.turn) {
+      units_turn = segment.turn;
+    } else if (segment.handle == mortido::api::kCommandHandle && units_turn) {
+      commands.try_emplace(*units_turn, segment.request);
+    }
+  }
+  return commands;
+}
+
+std::unordered_map<int, std::string> recorded_delta_commands(const std::filesystem::path& file) {
+  std::unordered_map<int, std::string> commands;
+  mortido::api::DeltaReader reader(file);
+  mortido::api::DeltaKind kind;
+  mortido::api::DumpRecord record;
+  mortido::models::UnitsSnapshot units;
+  std::optional<int> units_turn;
+  while (reader.next(kind, record, units)) {
+    if (kind != mortido::api::DeltaKind::record) {
+      units_turn = units.turn;
+    } else if (record.handle == mortido::api::kCommandHandle && units_turn) {
+      commands.try_emplace(*units_turn, std::move(record.request));
+    }
+  }
+  return commands;
+}
+
+std::string to_string(vec2i pos) {
+  return std::to_string(pos.x) + "," + std::to_string(pos.y);
+}
+
+template <typename T>
+size_t diff_sets(const std::set<T>& recorded, const std::set<T>& computed, const char* what,
+                 std::vector<std::string>& lines) {
+  size_t count = 0;
+  for (const auto& item : recorded) {
+    if (!computed.contains(item)) {
+      lines.push_back(std::string("- ") + what + " " + item);
+      count++;
+    }
+  }
+  for (const auto& item : computed) {
+    if (!recorded.contains(item)) {
+      lines.push_back(std::string("+ ") + what + " " + item);
+      count++;
+    }
+  }
+  return count;
+}
+
+std::set<std::string> attack_set(const Command& command) {
+  std::set<std::string> attacks;
+  for (const auto& attack : command.attack) {
+    attacks.insert(attack.block_id + " -> " + to_string(attack.target));
+  }
+  return attacks;
+}
+
+std::set<std::string> build_set(const Command& command) {
+  std::set<std::string> builds;
+  for (const auto& pos : command.build) {
+    builds.insert(to_string(pos));
+  }
+  return builds;
+}
+
+void compare(const Command& recorded, const Command& computed, TurnDiff& diff,
+             GameReport& report) {
+  report.attack_diffs +=
+      diff_sets(attack_set(recorded), attack_set(computed), "attack", diff.lines);
+  report.build_diffs += diff_sets(build_set(recorded), build_set(computed), "build", diff.lines);
+  if (recorded.move_base != computed.move_base) {
+    auto format = [](const std::optional<vec2i>& pos) {
+      return pos ? to_string(*pos) : std::string("none");
+    };
+    diff.lines.push_back("- move_base " + format(recorded.move_base));
+    diff.lines.push_back("+ move_base " + format(computed.move_base));
+    report.move_diffs++;
+  }
+}
+
+GameReport check(const std::filesystem::path& file) {
+  GameReport report;
+  try {
+    std::unordered_map<int, std::string> recorded;
+    if (mortido::tools::is_delta_file(file)) {
+      recorded = recorded_delta_commands(file);
+    } else {
+      mortido::api::MappedFile dump(file);
+      recorded = recorded_commands(dump.data());
+    }
+
+    mortido::api::CommandReader reader;
+    mortido::tools::ReplayRunner runner(file);
+    auto turns = runner.run([&](const TurnResult& result, const mortido::models::State&) {
+      auto it = recorded.find(result.turn);
+      if (it == recorded.end()) {
+        return;
+      }
+      report.compared++;
+      TurnDiff diff{.turn = result.turn, .lines = {}};
+      auto command = reader.decode(it->second);
+      if (!command) {
+        diff.lines.emplace_back("! recorded command does not parse");
+      } else {
+        compare(*command, result.command, diff, report);
+      }
+      if (!diff.lines.empty()) {
+        report.diffs.push_back(std::move(diff));
+      }
+    });
+    if (turns) {
+      report.ok = true;
+      report.turns = *turns;
+    } else {
+      report.error = "no world/units to replay";
+    }
+  } catch (const std::exception& e) {
+    report.error = e.what();
+  }
+  return report;
+}
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [-j <threads>] [--verbose] [--max-diffs <n>] <dir | file | 'glob'>...\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t threads = mortido::tools::default_threads();
+  bool verbose = false;
+  size_t max_diffs = 3;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else if (std::strcmp(argv[i], "--max-diffs") == 0 && i + 1 < argc) {
+      max_diffs = std::strtoul(argv[++i], nullptr, 10);
+    } else if (argv[i][0] != '-') {
+      inputs.emplace_back(argv[i]);
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  auto files = mortido::tools::collect_dump_files(inputs);
+  if (files.empty()) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+
+  std::vector<GameReport> reports(files.size());
+  auto start = std::chrono::steady_clock::now();
+  mortido::tools::parallel_for(files.size(), threads,
+                               [&](size_t, size_t i) { reports[i] = check(files[i]); });
+  double wall_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("%-40s %6s %9s %9s %8s %7s %6s\n", "game", "turns", "compared", "diverged",
+              "attacks", "builds", "moves");
+  size_t failed = 0;
+  size_t diverged_games = 0;
+  size_t compared = 0;
+  size_t diverged = 0;
+  for (size_t i = 0; i < files.size(); i++) {
+    const auto& report = reports[i];
+    auto name = files[i].filename().string();
+    if (!report.ok) {
+      std::fprintf(stderr, "%s: %s\n", files[i].c_str(), report.error.c_str());
+      failed++;
+      continue;
+    }
+    std::printf("%-40s %6zu %9zu %9zu %8zu %7zu %6zu\n", name.c_str(), report.turns,
+                report.compared, report.diverged(), report.attack_diffs, report.build_diffs,
+                report.move_diffs);
+    compared += report.compared;
+    diverged += report.diverged();
+    diverged_games += report.diverged() > 0;
+    if (report.compared == 0) {
+      std::fprintf(stderr, "%s: no recorded commands to compare\n", files[i].c_str());
+      failed++;
+    }
+
+    size_t shown = verbose ? report.diffs.size() : std::min(max_diffs, report.diffs.size());
+    for (size_t d = 0; d < shown; d++) {
+      std::printf("  turn %d:\n", report.diffs[d].turn);
+      for (const auto& line : report.diffs[d].lines) {
+        std::printf("    %s\n", line.c_str());
+      }
+    }
+    if (shown < report.diffs.size()) {
+      std::printf("  ... %zu more diverging turns\n", report.diffs.size() - shown);
+    }
+  }
+
+  std::printf("\n%zu games (%zu failed, %zu diverged), %zu of %zu compared turns diverged, "
+              "%.1f ms\n",
+              files.size(), failed, diverged_games, diverged, compared, wall_ms);
+  return failed == 0 && diverged == 0 && compared > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,126 @@
+// Headless replay of a dump_v2 or delta (.dlt) file: drives models::State through every
+// recorded turn with no sleeps and no network, printing the decision and per-phase timings of
+// each turn.
+//
+// usage: mortido-replay [--from <turn>] [--commands] [--quiet] <file.dump | file.dlt>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <string>
+
+#include "api/command_writer.h"
+#include "logger.h"
+#include "replay_runner.h"
+
+namespace {
+
+using mortido::tools::kPhaseNames;
+using mortido::tools::Phase;
+using mortido::tools::TurnResult;
+
+constexpr size_t kPhases = static_cast<size_t>(Phase::count);
+
+double to_us(int64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+void print_usage(const char* name) {
+  std::fprintf(stderr, "usage: %s [--from <turn>] [--commands] [--quiet] <file.dump | file.dlt>\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::optional<int> start_turn;
+  bool print_commands = false;
+  bool quiet = false;
+  const char* dump_file = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc) {
+      start_turn = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--commands") == 0) {
+      print_commands = true;
+    } else if (std::strcmp(argv[i], "--quiet") == 0) {
+      quiet = true;
+    } else if (argv[i][0] != '-' && dump_file == nullptr) {
+      dump_file = argv[i];
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (dump_file == nullptr) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Decisions are the output here, the State's own logging would only slow the replay down.
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+
+  mortido::api::CommandWriter command_writer;
+  int64_t phase_total_ns[kPhases] = {};
+  size_t attacks = 0;
+  size_t builds = 0;
+  size_t base_moves = 0;
+  int predicted_kills = 0;
+
+  if (!quiet) {
+    std::printf("%5s %7s %6s %4s %5s", "turn", "attacks", "builds", "move", "kills");
+    for (const char* name : kPhaseNames) {
+      std::printf(" %10s", name);
+    }
+    std::printf(" %10s\n", "total_us");
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::optional<size_t> turns;
+  try {
+    mortido::tools::ReplayRunner runner(dump_file, start_turn);
+    turns = runner.run([&](const TurnResult& result, const mortido::models::State&) {
+      for (size_t i = 0; i < kPhases; i++) {
+        phase_total_ns[i] += result.phase_ns[i];
+      }
+      attacks += result.command.attack.size();
+      builds += result.command.build.size();
+      base_moves += result.command.move_base.has_value();
+      predicted_kills += result.predicted_kills;
+      if (quiet) {
+        return;
+      }
+
+      std::printf("%5d %7zu %6zu %4s %5d", result.turn, result.command.attack.size(),
+                  result.command.build.size(), result.command.move_base ? "yes" : "-",
+                  result.predicted_kills);
+      for (auto ns : result.phase_ns) {
+        std::printf(" %10.1f", to_us(ns));
+      }
+      std::printf(" %10.1f\n", to_us(result.total_ns()));
+      if (print_commands) {
+        auto json = command_writer.encode(result.command);
+        std::printf("      %.*s\n", static_cast<int>(json.size()), json.data());
+      }
+    });
+  } catch (const std::exception& e) {
+    std::fprintf(stderr, "%s: %s\n", dump_file, e.what());
+    return EXIT_FAILURE;
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  if (!turns) {
+    std::fprintf(stderr, "%s: no world/units to replay\n", dump_file);
+    return EXIT_FAILURE;
+  }
+
+  std::printf("\n%s: %zu turns in %.1f ms, %zu attacks, %zu builds, %zu base moves, "
+              "%d predicted kills\n",
+              dump_file, *turns, std::chrono::duration<double, std::milli>(elapsed).count(),
+              attacks, builds, base_moves, predicted_kills);
+  for (size_t i = 0; i < kPhases; i++) {
+    std::printf("  %-10s %10.1f ms total %10.1f us/turn\n", kPhaseNames[i],
+                to_us(phase_total_ns[i]) / 1000.0,
+                *turns > 0 ? to_us(phase_total_ns[i]) / static_cast<double>(*turns) : 0.0);
+  }
+  return EXIT_SUCCESS;
+}
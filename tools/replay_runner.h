@@ -0,0 +1,178 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "api/delta_file.h"
+#include "api/dump_v2.h"
+#include "api/json_arena.h"
+#include "api/responses.h"
+#include "models/state.h"
+#include "models/units_reader.h"
+
+namespace mortido::tools {
+
+// Decision pipeline phases timed per turn.
+enum class Phase { decode, update, world, attack, build, move_base, count };
+
+constexpr const char* kPhaseNames[] = {"decode", "update", "world", "attack", "build", "move_base"};
+
+struct TurnResult {
+  int turn = 0;
+  api::Command command;
+  int predicted_kills = 0;  // zombies the chosen attacks are expected to finish
+  int64_t phase_ns[static_cast<size_t>(Phase::count)] = {};
+
+  [[nodiscard]] int64_t total_ns() const {
+    int64_t total = 0;
+    for (auto ns : phase_ns) total += ns;
+    return total;
+  }
+};
+
+inline bool is_delta_file(const std::filesystem::path& file) {
+  return file.extension() == ".dlt";
+}
+
+// Drives models::State from a dump_v2 file the way Game::game_loop does, minus the lobby
+// waits, sleeps and network: world, then for every turn units -> (world) -> action. Delta
+// dumps (.dlt, api/delta_file.h) are replayed directly from their decoded states.
+class ReplayRunner {
+ public:
+  explicit ReplayRunner(std::filesystem::path dump_file,
+                        std::optional<int> start_turn = std::nullopt,
+                        const models::Params& params = {}) {
+    if (is_delta_file(dump_file)) {
+      delta_.emplace(dump_file, start_turn);
+    } else {
+      api_.emplace(std::move(dump_file), start_turn);
+      api_->set_json_arena(&json_arena_);
+    }
+    state_.set_params(params);
+  }
+
+  ReplayRunner(const ReplayRunner&) = delete;
+  ReplayRunner& operator=(const ReplayRunner&) = delete;
+
+  // Calls `on_turn(const TurnResult&, const models::State&)` after each decision. Returns the
+  // number of turns decided, or nullopt if the dump has no usable world/units.
+  template <typename F>
+  std::optional<size_t> run(F&& on_turn) {
+    TurnResult result;
+    if (!timed(result, Phase::world, [&] { return load_world(); })) {
+      return std::nullopt;
+    }
+
+    size_t turns = 0;
+    while (!state_.game_ended_at && state_.turn < 449 && active()) {
+      json_arena_.next_turn();
+      result = TurnResult{};
+      if (!timed(result, Phase::decode, [&] { return decode_units(); })) {
+        break;
+      }
+      timed(result, Phase::update, [&] {
+        state_.update_from_units(delta_ ? delta_->units() : units_);
+        return true;
+      });
+      if (state_.game_ended_at) {
+        break;
+      }
+      if (state_.map.view_zone_updated &&
+          !timed(result, Phase::world, [&] { return load_world(); })) {
+        break;
+      }
+
+      int gold = state_.me.gold;
+      timed(result, Phase::attack, [&] {
+        result.command.attack = state_.attack();
+        return true;
+      });
+      result.predicted_kills = state_.me.gold - gold;
+      timed(result, Phase::build, [&] {
+        result.command.build = state_.build();
+        return true;
+      });
+      timed(result, Phase::move_base, [&] {
+        result.command.move_base = state_.move_base();
+        return true;
+      });
+
+      result.turn = state_.turn;
+      on_turn(static_cast<const TurnResult&>(result), static_cast<const models::State&>(state_));
+      send_command(result.command);
+      turns++;
+    }
+    return turns;
+  }
+
+ private:
+  std::optional<api::DumpApi> api_;
+  std::optional<api::DeltaReplay> delta_;
+  int delta_turn_ = 0;  // the turn DeltaReplay is asked for next, as DumpApi counts it
+  bool delta_ended_ = false;
+  api::JsonArena json_arena_;
+  models::State state_;
+  models::UnitsReader units_reader_;
+  models::UnitsSnapshot units_;
+
+  template <typename F>
+  static bool timed(TurnResult& result, Phase phase, F&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    bool ok = fn();
+    result.phase_ns[static_cast<size_t>(phase)] +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                             start)
+            .count();
+    return ok;
+  }
+
+  bool active() { return delta_ ? !delta_ended_ : api_->active(); }
+
+  void send_command(const api::Command& command) {
+    if (delta_) {
+      delta_turn_++;
+    } else {
+      api_->send_command(command);
+    }
+  }
+
+  bool seek_delta() {
+    delta_ended_ = delta_ended_ || !delta_->seek_turn(delta_turn_);
+    if (!delta_ended_) {
+      delta_turn_ = *delta_->units().turn;
+    }
+    return !delta_ended_;
+  }
+
+  api::JsonDocument delta_world() {
+    seek_delta();
+    auto world = json_arena_.make_document();
+    auto json = delta_->world_json();
+    world.Parse(json.data(), json.size());
+    return world;
+  }
+
+  bool load_world() {
+    auto world = delta_ ? delta_world() : api_->get_world();
+    if (world.HasParseError() || !world.IsObject() || api::Error::from_json(world)) {
+      return false;
+    }
+    state_.init_from_json(world);
+    return true;
+  }
+
+  // DumpApi only stops at units that carry a turn, so an error here means the dump ended. Delta
+  // dumps only hold such units.
+  bool decode_units() {
+    if (delta_) {
+      return seek_delta();
+    }
+    return units_reader_.read(api_->get_units_json(), units_) && !units_.error();
+  }
+};
+
+}  // namespace mortido::tools
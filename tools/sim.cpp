@@ -0,0 +1,154 @@
+// Plays whole games of the bot (game::Game) against the local simulator (api/sim.h), several
+// seeds in parallel, and prints how each game went. Meant for closed-loop evaluation of
+// strategy changes offline: same seeds, same games. With --perf every game's phase timings
+// (perf.h) and deadline margins (deadline.h) are written to <dir>/sim-<seed>.perf and .deadline,
+// as the bot does for real rounds. Built with
+// TRACE, --trace writes the timeline of all games (one track per worker thread); built with
+// ALLOC_TRACKING, the .perf files also count allocations per phase. --check verifies the
+// simulator's zombie index after every turn and fails if any game breaks it.
+//
+// usage: mortido-sim [--seed <first seed>] [--games <count>] [--turns <max turns>] [-j <threads>]
+//            [--perf <dir>] [--trace <file.json>] [--check]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "api/sim.h"
+#include "game.h"
+#include "logger.h"
+#include "task_pool.h"
+
+#ifdef ALLOC_TRACKING
+#include "alloc_hooks.h"
+#endif
+
+namespace {
+
+struct GameResult {
+  uint32_t seed = 0;
+  int turns = 0;
+  bool survived = false;
+  mortido::sim::PlayerStats me;
+  size_t blocks = 0;
+  double ms = 0.0;
+  double engine_ms = 0.0;
+  std::optional<int> broken_index_turn;
+};
+
+GameResult play(const mortido::sim::Config& config, const std::filesystem::path& perf_dir,
+                bool check) {
+  auto start = std::chrono::steady_clock::now();
+  mortido::api::SimApi api(config);
+  api.set_check_index(check);
+  const auto& engine = api.engine();
+  mortido::game::Game game(engine.name(), api);
+  game.run();
+  if (!perf_dir.empty()) {
+    game.profile().write(perf_dir / (engine.name() + ".perf"), engine.name());
+    game.deadlines().write(perf_dir / (engine.name() + ".deadline"), engine.name());
+  }
+
+  GameResult result;
+  result.seed = config.seed;
+  result.turns = engine.turn();
+  result.me = engine.player(mortido::sim::Engine::kUs);
+  result.survived = result.me.alive;
+  result.blocks = engine.block_count(mortido::sim::Engine::kUs);
+  result.ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  result.engine_ms = std::chrono::duration<double, std::milli>(api.engine_time()).count();
+  result.broken_index_turn = api.broken_index_turn();
+  return result;
+}
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [--seed <first seed>] [--games <count>] [--turns <max turns>] "
+               "[-j <threads>] [--perf <dir>] [--trace <file.json>] [--check]\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t threads = mortido::tools::default_threads();
+  mortido::sim::Config config;
+  size_t games = 1;
+  std::filesystem::path perf_dir;
+  std::filesystem::path trace_file;
+  bool check = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+      games = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--turns") == 0 && i + 1 < argc) {
+      config.max_turns = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--perf") == 0 && i + 1 < argc) {
+      perf_dir = argv[++i];
+    } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      trace_file = argv[++i];
+    } else if (std::strcmp(argv[i], "--check") == 0) {
+      check = true;
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+
+  std::vector<GameResult> results(games);
+  auto start = std::chrono::steady_clock::now();
+  mortido::tools::parallel_for(games, threads, [&](size_t, size_t i) {
+    auto game_config = config;
+    game_config.seed = config.seed + static_cast<uint32_t>(i);
+    results[i] = play(game_config, perf_dir, check);
+  });
+  double wall_ms =
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!trace_file.empty()) {
+#ifdef TRACE
+    mortido::trace::Tracer::instance().write(trace_file);
+#else
+    std::fprintf(stderr, "--trace needs a build with -DTRACE=ON\n");
+#endif
+  }
+
+  std::printf("%10s %6s %9s %8s %8s %6s %7s %7s %9s %9s\n", "seed", "turns", "survived",
+              "zombies", "blocks", "gold", "points", "base", "ms", "sim_ms");
+  size_t turns = 0;
+  size_t survived = 0;
+  long long points = 0;
+  double engine_ms = 0.0;
+  size_t broken = 0;
+  for (const auto& r : results) {
+    std::printf("%10u %6d %9s %8d %8d %6d %7d %7zu %9.1f %9.1f\n", r.seed, r.turns,
+                r.survived ? "yes" : "no", r.me.zombie_kills, r.me.block_kills, r.me.gold,
+                r.me.points, r.blocks, r.ms, r.engine_ms);
+    turns += r.turns;
+    survived += r.survived;
+    points += r.me.points;
+    engine_ms += r.engine_ms;
+    if (r.broken_index_turn) {
+      std::fprintf(stderr, "seed %u: zombie index broken after turn %d\n", r.seed,
+                   *r.broken_index_turn);
+      broken++;
+    }
+  }
+  std::printf("\n%zu games, %zu survived, %.1f points/game, %zu turns in %.1f ms: %.0f turns/s "
+              "(simulator alone: %.0f turns/s)\n",
+              games, survived, static_cast<double>(points) / static_cast<double>(games), turns,
+              wall_ms, static_cast<double>(turns) / wall_ms * 1000.0,
+              static_cast<double>(turns) / std::max(engine_ms, 1e-3) * 1000.0);
+  return broken == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,133 @@
+// Writes a synthetic late-game dump_v2 with exact entity counts (sim/scenario.h): one `/world`
+// and a `/units` per turn, zombies moving between turns. Drives DumpApi, mortido-replay,
+// mortido-batch-replay and the benchmarks on worst-case turns without waiting for a real
+// game to get there.
+//
+// usage: mortido-stress-gen [--seed <n>] [--turns <n>] [--start-turn <n>] [--size <n>]
+//            [--zpots <n>] [--walls <n>] [--base <n>] [--enemy <n>] [--zombies <n>]
+//            [--normal <n>] [--fast <n>] [--bomber <n>] [--liner <n>] [--juggernaut <n>]
+//            [--chaos-knight <n>] <out.dump>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "api/dump_format.h"
+#include "models/units_writer.h"
+#include "sim/scenario.h"
+
+namespace {
+
+using mortido::api::DumpRecord;
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [--seed <n>] [--turns <n>] [--start-turn <n>] [--size <n>] "
+               "[--zpots <n>] [--walls <n>] [--base <n>] [--enemy <n>] [--zombies <n>] "
+               "[--normal <n>] [--fast <n>] [--bomber <n>] [--liner <n>] [--juggernaut <n>] "
+               "[--chaos-knight <n>] <out.dump>\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  mortido::sim::ScenarioConfig config;
+  int turns = 10;
+  const char* output = nullptr;
+  static const char* kTypeFlags[] = {"--normal", "--fast", "--bomber", "--liner",
+                                     "--juggernaut", "--chaos-knight"};
+  for (int i = 1; i < argc; i++) {
+    std::string_view flag = argv[i];
+    if (flag[0] != '-') {
+      output = argv[i];
+      continue;
+    }
+    if (i + 1 >= argc) {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+    auto value = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+    bool known = true;
+    if (flag == "--seed") {
+      config.seed = static_cast<uint32_t>(value);
+    } else if (flag == "--turns") {
+      turns = std::max(1, static_cast<int>(value));
+    } else if (flag == "--start-turn") {
+      config.turn = static_cast<int>(value);
+    } else if (flag == "--size") {
+      config.size = std::max(10, static_cast<int>(value));
+    } else if (flag == "--zpots") {
+      config.spawns = value;
+    } else if (flag == "--walls") {
+      config.walls = value;
+    } else if (flag == "--base") {
+      config.base = std::max<size_t>(1, value);
+    } else if (flag == "--enemy") {
+      config.enemy = value;
+    } else if (flag == "--zombies") {
+      config.set_zombies(value);
+    } else {
+      known = false;
+      for (size_t type = 0; type < config.zombies.size(); type++) {
+        if (flag == kTypeFlags[type]) {
+          config.zombies[type] = value;
+          known = true;
+        }
+      }
+    }
+    if (!known) {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (output == nullptr) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream out(output, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    std::fprintf(stderr, "%s: could not open\n", output);
+    return EXIT_FAILURE;
+  }
+  std::string text;
+  auto write = [&](std::string_view method, std::string_view handle, std::string_view request,
+                   std::string_view response) {
+    DumpRecord record;
+    record.method = method;
+    record.handle = handle;
+    record.request = request;
+    record.http_code = 200;
+    record.response = response;
+    text.clear();
+    mortido::api::format_dump_record(record, text);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+  };
+
+  mortido::sim::ScenarioGenerator generator(config);
+  auto scenario = generator.generate();
+  mortido::models::UnitsWriter units_writer;
+  size_t units_bytes = 0;
+  write("PUT", "/play/zombidef/participate", "", "{\"startsInSec\": 0}");
+  write("GET", mortido::api::kWorldHandle, "", scenario.world_json());
+  for (int turn = 0; turn < turns; turn++) {
+    if (turn > 0) {
+      generator.advance(scenario);
+    }
+    auto body = units_writer.encode(scenario.units);
+    units_bytes += body.size();
+    write("GET", mortido::api::kUnitsHandle, "", body);
+  }
+
+  const auto& units = scenario.units;
+  std::printf("%s: %d turns from %d, %zu zpots, %zu walls, %zu blocks, %zu enemy blocks, "
+              "%zu zombies, %.1f KB per /units\n",
+              output, turns, config.turn, scenario.spawns.size(), scenario.walls.size(),
+              units.base.size(), units.enemy_blocks.size(), units.zombies.size(),
+              static_cast<double>(units_bytes) / turns / 1024.0);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,282 @@
+// Evaluates strategy parameter sets (models::Params) in parallel and prints them ranked.
+// A parameter set is scored on simulated games (closed loop, mean points; see api/sim.h) or,
+// without --sim, on dump replays (open loop, mean kills predicted by the chosen attacks).
+// The defaults are always evaluated as the baseline.
+//
+// Parameters are given as name=values:
+//   name=a,b,c      these values
+//   name=lo:hi      5 evenly spaced values in a grid, a uniform sample with --random
+//   name=lo:hi:n    n evenly spaced values
+// Without --random every combination is evaluated (grid search), with --random <count> that
+// many sets are sampled.
+//
+// usage: mortido-sweep [-j <threads>] [--sim <games>] [--seed <first seed>] [--turns <turns>]
+//            [--random <count>] [--rng-seed <seed>] [--top <rows>] name=values...
+//            [<dir | file | 'glob'>...]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "api/sim.h"
+#include "dump_files.h"
+#include "game.h"
+#include "logger.h"
+#include "models/params.h"
+#include "replay_runner.h"
+#include "task_pool.h"
+
+namespace {
+
+using mortido::models::Params;
+
+struct ParamSpec {
+  std::string name;
+  std::vector<double> values;  // listed or grid values
+  bool range = false;
+  double lo = 0.0;
+  double hi = 0.0;
+};
+
+struct Evaluation {
+  Params params;
+  size_t games = 0;
+  size_t failed = 0;
+  double score_sum = 0.0;  // points (simulation) or predicted kills (replay)
+  size_t turns = 0;
+  size_t survived = 0;
+  double ms = 0.0;
+
+  [[nodiscard]] double score() const {
+    return games > failed ? score_sum / static_cast<double>(games - failed) : 0.0;
+  }
+};
+
+std::optional<ParamSpec> parse_spec(const std::string& arg) {
+  size_t eq = arg.find('=');
+  ParamSpec spec;
+  spec.name = arg.substr(0, eq);
+  if (!Params{}.set(spec.name, 0.0)) {
+    std::fprintf(stderr, "unknown parameter: %s\n", spec.name.c_str());
+    return std::nullopt;
+  }
+  std::string values = arg.substr(eq + 1);
+  if (values.find(':') != std::string::npos) {
+    char* end = nullptr;
+    spec.range = true;
+    spec.lo = std::strtod(values.c_str(), &end);
+    spec.hi = std::strtod(end + 1, &end);
+    int steps = *end == ':' ? std::max(1, std::atoi(end + 1)) : 5;
+    for (int i = 0; i < steps; i++) {
+      spec.values.push_back(steps == 1 ? spec.lo : spec.lo + (spec.hi - spec.lo) * i / (steps - 1));
+    }
+  } else {
+    for (size_t begin = 0; begin <= values.size();) {
+      size_t end = std::min(values.find(',', begin), values.size());
+      spec.values.push_back(std::strtod(values.c_str() + begin, nullptr));
+      begin = end + 1;
+    }
+  }
+  return spec;
+}
+
+std::vector<Params> grid(const std::vector<ParamSpec>& specs) {
+  std::vector<Params> sets = {Params{}};
+  for (const auto& spec : specs) {
+    std::vector<Params> next;
+    for (const auto& params : sets) {
+      for (double value : spec.values) {
+        next.push_back(params);
+        next.back().set(spec.name, value);
+      }
+    }
+    sets = std::move(next);
+  }
+  return sets;
+}
+
+std::vector<Params> random_search(const std::vector<ParamSpec>& specs, size_t count,
+                                  uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::vector<Params> sets(count);
+  for (auto& params : sets) {
+    for (const auto& spec : specs) {
+      if (spec.range) {
+        params.set(spec.name, std::uniform_real_distribution<double>(spec.lo, spec.hi)(rng));
+      } else {
+        size_t index = std::uniform_int_distribution<size_t>(0, spec.values.size() - 1)(rng);
+        params.set(spec.name, spec.values[index]);
+      }
+    }
+  }
+  return sets;
+}
+
+struct GameOutcome {
+  bool ok = false;
+  double score = 0.0;
+  size_t turns = 0;
+  bool survived = false;
+};
+
+GameOutcome simulate(const Params& params, uint32_t seed, int max_turns) {
+  mortido::sim::Config config;
+  config.seed = seed;
+  config.max_turns = max_turns;
+  mortido::api::SimApi api(config);
+  const auto& engine = api.engine();
+  mortido::game::Game game(engine.name(), api, params);
+  game.run();
+  const auto& me = engine.player(mortido::sim::Engine::kUs);
+  return GameOutcome{.ok = true,
+                     .score = static_cast<double>(me.points),
+                     .turns = static_cast<size_t>(engine.turn()),
+                     .survived = me.alive};
+}
+
+GameOutcome replay(const Params& params, const std::filesystem::path& file) {
+  GameOutcome outcome;
+  try {
+    mortido::tools::ReplayRunner runner(file, std::nullopt, params);
+    auto turns = runner.run([&](const mortido::tools::TurnResult& result,
+                                const mortido::models::State&) {
+      outcome.score += result.predicted_kills;
+    });
+    outcome.ok = turns.has_value();
+    outcome.turns = turns.value_or(0);
+  } catch (const std::exception& e) {
+    LOG_ERROR("%s: %s", file.c_str(), e.what());
+  }
+  return outcome;
+}
+
+void print_usage(const char* name) {
+  std::fprintf(stderr,
+               "usage: %s [-j <threads>] [--sim <games>] [--seed <first seed>] [--turns <turns>] "
+               "[--random <count>] [--rng-seed <seed>] [--top <rows>] name=values... "
+               "[<dir | file | 'glob'>...]\n",
+               name);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  size_t threads = mortido::tools::default_threads();
+  size_t sim_games = 0;
+  uint32_t first_seed = 1;
+  int max_turns = mortido::sim::Config{}.max_turns;
+  size_t random_count = 0;
+  uint32_t rng_seed = 1;
+  size_t top = 20;
+  std::vector<ParamSpec> specs;
+  std::vector<std::string> inputs;
+  for (int i = 1; i < argc; i++) {
+    auto next = [&] { return i + 1 < argc ? argv[++i] : nullptr; };
+    const char* value = nullptr;
+    if (std::strcmp(argv[i], "-j") == 0 && (value = next())) {
+      threads = std::max(1, std::atoi(value));
+    } else if (std::strcmp(argv[i], "--sim") == 0 && (value = next())) {
+      sim_games = std::max(1, std::atoi(value));
+    } else if (std::strcmp(argv[i], "--seed") == 0 && (value = next())) {
+      first_seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(argv[i], "--turns") == 0 && (value = next())) {
+      max_turns = std::max(1, std::atoi(value));
+    } else if (std::strcmp(argv[i], "--random") == 0 && (value = next())) {
+      random_count = std::max(1, std::atoi(value));
+    } else if (std::strcmp(argv[i], "--rng-seed") == 0 && (value = next())) {
+      rng_seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    } else if (std::strcmp(argv[i], "--top") == 0 && (value = next())) {
+      top = std::max(1, std::atoi(value));
+    } else if (argv[i][0] != '-' && std::strchr(argv[i], '=') != nullptr) {
+      auto spec = parse_spec(argv[i]);
+      if (!spec) {
+        return EXIT_FAILURE;
+      }
+      specs.push_back(std::move(*spec));
+    } else if (argv[i][0] != '-') {
+      inputs.emplace_back(argv[i]);
+    } else {
+      print_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  auto files = mortido::tools::collect_dump_files(inputs);
+  if (specs.empty() || (sim_games == 0 && files.empty())) {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  loguru::g_stderr_verbosity = loguru::Verbosity_ERROR;
+
+  std::vector<Evaluation> evaluations;
+  evaluations.emplace_back();  // baseline
+  for (auto& params : random_count > 0 ? random_search(specs, random_count, rng_seed)
+                                       : grid(specs)) {
+    evaluations.emplace_back().params = params;
+  }
+  size_t games = sim_games > 0 ? sim_games : files.size();
+  for (auto& evaluation : evaluations) {
+    evaluation.games = games;
+  }
+  std::printf("%zu parameter sets x %zu %s on %zu threads\n", evaluations.size(), games,
+              sim_games > 0 ? "simulated games" : "dumps", threads);
+
+  // One job per (parameter set, game); outcomes are summed per set afterwards, so the result
+  // doesn't depend on the scheduling.
+  std::vector<GameOutcome> outcomes(evaluations.size() * games);
+  std::vector<double> job_ms(outcomes.size());
+  auto start = std::chrono::steady_clock::now();
+  mortido::tools::parallel_for(outcomes.size(), threads, [&](size_t, size_t job) {
+    auto job_start = std::chrono::steady_clock::now();
+    const auto& params = evaluations[job / games].params;
+    size_t game = job % games;
+    outcomes[job] = sim_games > 0
+                        ? simulate(params, first_seed + static_cast<uint32_t>(game), max_turns)
+                        : replay(params, files[game]);
+    job_ms[job] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                            job_start)
+                      .count();
+  });
+  double wall_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  for (size_t job = 0; job < outcomes.size(); job++) {
+    auto& evaluation = evaluations[job / games];
+    const auto& outcome = outcomes[job];
+    evaluation.ms += job_ms[job];
+    if (!outcome.ok) {
+      evaluation.failed++;
+      continue;
+    }
+    evaluation.score_sum += outcome.score;
+    evaluation.turns += outcome.turns;
+    evaluation.survived += outcome.survived;
+  }
+
+  const Params defaults;
+  double baseline = evaluations.front().score();
+  std::vector<size_t> order(evaluations.size());
+  for (size_t i = 0; i < order.size(); i++) order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return evaluations[a].score() > evaluations[b].score();
+  });
+
+  std::printf("\n%5s %10s %9s %8s %9s %10s  %s\n", "rank", "score", "vs_base", "turns",
+              sim_games > 0 ? "survived" : "failed", "ms/game", "params");
+  for (size_t rank = 0; rank < std::min(top, order.size()); rank++) {
+    const auto& e = evaluations[order[rank]];
+    std::printf("%5zu %10.2f %+9.2f %8zu %9zu %10.1f  %s\n", rank + 1, e.score(),
+                e.score() - baseline, e.turns / std::max<size_t>(1, e.games - e.failed),
+                sim_games > 0 ? e.survived : e.failed, e.ms / static_cast<double>(e.games),
+                order[rank] == 0 ? "baseline" : e.params.diff(defaults).c_str());
+  }
+  std::printf("\n%zu games in %.1f s\n", outcomes.size(), wall_s);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace mortido::tools {
+
+// Runs fn(worker, index) for every index in [0, count) on `threads` workers. Indices are dealt
+// round-robin into per-worker deques: a worker takes from the back of its own deque and, once
+// it is empty, steals from the front of the others, so a few long jobs don't leave cores idle.
+template <typename F>
+void parallel_for(size_t count, size_t threads, F&& fn) {
+  threads = std::max<size_t>(1, std::min(threads, count));
+  struct Queue {
+    std::mutex mutex;
+    std::deque<size_t> items;
+  };
+  std::vector<Queue> queues(threads);
+  for (size_t i = 0; i < count; i++) {
+    queues[i % threads].items.push_back(i);
+  }
+
+  auto pop = [&](size_t worker) -> std::optional<size_t> {
+    {
+      std::lock_guard lock(queues[worker].mutex);
+      auto& items = queues[worker].items;
+      if (!items.empty()) {
+        size_t index = items.back();
+        items.pop_back();
+        return index;
+      }
+    }
+    for (size_t k = 1; k < threads; k++) {
+      auto& victim = queues[(worker + k) % threads];
+      std::lock_guard lock(victim.mutex);
+      if (!victim.items.empty()) {
+        size_t index = victim.items.front();
+        victim.items.pop_front();
+        return index;
+      }
+    }
+    return std::nullopt;
+  };
+
+  auto work = [&](size_t worker) {
+    while (auto index = pop(worker)) {
+      fn(worker, *index);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t worker = 1; worker < threads; worker++) {
+    workers.emplace_back(work, worker);
+  }
+  work(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+// `hardware_concurrency` with a sane fallback.
+inline size_t default_threads() { return std::max(1u, std::thread::hardware_concurrency()); }
+
+}  // namespace mortido::tools
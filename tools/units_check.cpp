@@ -0,0 +1,139 @@
+// Replays `/units` responses from dump_v2 files through both the DOM and the SAX decoders and
+// checks that they produce identical State.
+//
+// usage: mortido-units-check <file.dump>...
+
+#include <rapidjson/document.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "api/dump_format.h"
+#include "api/responses.h"
+#include "models/state.h"
+#include "models/units_reader.h"
+
+namespace {
+
+using mortido::models::Building;
+using mortido::models::State;
+using mortido::models::Zombie;
+
+bool same_building(const Building& a, const Building& b) {
+  return a.attack == b.attack && a.health == b.health && a.is_head == b.is_head &&
+         a.is_enemy == b.is_enemy && a.range == b.range && a.player_name == b.player_name &&
+         a.id == b.id && a.last_attack == b.last_attack && a.position == b.position &&
+         a.danger == b.danger;
+}
+
+bool same_zombie(const Zombie& a, const Zombie& b) {
+  return a.attack == b.attack && a.health == b.health && a.wait_turns == b.wait_turns &&
+         a.id == b.id && a.type == b.type && a.direction == b.direction && a.speed == b.speed &&
+         a.position == b.position && a.danger == b.danger;
+}
+
+// Returns the name of the first differing field or nullptr.
+const char* compare(State& dom, State& sax) {
+  if (dom.turn != sax.turn) return "turn";
+  if (dom.game_ended_at != sax.game_ended_at) return "game_ended_at";
+  if (dom.me.name != sax.me.name || dom.me.gold != sax.me.gold ||
+      dom.me.enemy_block_kills != sax.me.enemy_block_kills || dom.me.points != sax.me.points ||
+      dom.me.zombie_kills != sax.me.zombie_kills) {
+    return "player";
+  }
+
+  const auto& a = dom.map;
+  const auto& b = sax.map;
+  if (a.buildings.size() != b.buildings.size()) return "buildings.size";
+  for (size_t i = 0; i < a.buildings.size(); i++) {
+    if (!same_building(a.buildings[i], b.buildings[i])) return "buildings";
+  }
+  if (a.zombies.size() != b.zombies.size()) return "zombies.size";
+  for (size_t i = 0; i < a.zombies.size(); i++) {
+    if (!same_zombie(a.zombies[i], b.zombies[i])) return "zombies";
+  }
+  if (a.my_buildings != b.my_buildings) return "my_buildings";
+  if (a.enemy_buildings != b.enemy_buildings) return "enemy_buildings";
+  if (a.my_base != b.my_base) return "my_base";
+  if (a.my_active_buildings != b.my_active_buildings) return "my_active_buildings";
+  if (a.build_candidates != b.build_candidates) return "build_candidates";
+  if (a.size != b.size) return "map.size";
+
+  auto dom_action = dom.get_action();
+  auto sax_action = sax.get_action();
+  if (dom_action.attack.size() != sax_action.attack.size()) return "action.attack";
+  for (size_t i = 0; i < dom_action.attack.size(); i++) {
+    if (dom_action.attack[i].block_id != sax_action.attack[i].block_id ||
+        dom_action.attack[i].target != sax_action.attack[i].target) {
+      return "action.attack";
+    }
+  }
+  if (dom_action.build != sax_action.build) return "action.build";
+  if (dom_action.move_base != sax_action.move_base) return "action.move_base";
+  return nullptr;
+}
+
+bool check_dump(const std::string& path) {
+  std::ifstream in(path);
+  if (!in.is_open()) {
+    std::cerr << path << ": could not open" << std::endl;
+    return false;
+  }
+
+  State dom;
+  State sax;
+  mortido::models::UnitsReader reader;
+  mortido::models::UnitsSnapshot units;
+  mortido::api::DumpRecord record;
+  std::string line;
+  size_t checked = 0;
+
+  while (mortido::api::read_dump_record(in, record, line)) {
+    const auto& body = record.response;
+    if (record.handle == mortido::api::kWorldHandle) {
+      rapidjson::Document doc;
+      if (!doc.Parse(body.c_str()).HasParseError() && doc.IsObject()) {
+        dom.init_from_json(doc);
+        sax.init_from_json(doc);
+      }
+    } else if (record.handle == mortido::api::kUnitsHandle) {
+      rapidjson::Document doc;
+      bool dom_ok = !doc.Parse(body.c_str()).HasParseError() && doc.IsObject() &&
+                    !mortido::api::Error::from_json(doc) && doc.HasMember("turn");
+      bool sax_ok = reader.read(body, units) && !units.error() && units.turn;
+      if (dom_ok != sax_ok) {
+        std::cerr << path << ": decoders disagree on validity of units response" << std::endl;
+        return false;
+      }
+      if (!dom_ok) {
+        continue;
+      }
+      dom.update_from_json(doc);
+      sax.update_from_units(units);
+      if (const char* field = compare(dom, sax)) {
+        std::cerr << path << ": turn " << dom.turn << " mismatch in " << field << std::endl;
+        return false;
+      }
+      checked++;
+    }
+  }
+
+  std::cout << path << ": " << checked << " units responses identical" << std::endl;
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <file.dump>..." << std::endl;
+    return EXIT_FAILURE;
+  }
+  bool ok = true;
+  for (int i = 1; i < argc; i++) {
+    ok = check_dump(argv[i]) && ok;
+  }
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}